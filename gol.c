@@ -22,11 +22,7 @@ int main(int argc, char* argv[])
 	gol_array* temp;//for swaps;
 	gol_array* ga1;
 	gol_array* ga2;
-	int i, j;
-
-	//allocate and init two NxM gol_arrays
-	ga1 = gol_array_init(N, M);
-	ga2 = gol_array_init(N, M);
+	int i;
 
 	char* filename = NULL;
 
@@ -57,6 +53,9 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	//allocate and init two NxM gol_arrays (one aligned arena with padded rows)
+	gol_array_init_arena(N, M, 1, &ga1, &ga2);
+
 	if (argc == 2 || argc == 4)
 	{
 		filename = argv[1];
@@ -88,27 +87,24 @@ int main(int argc, char* argv[])
 	{
 		count++;
 		no_change = 1;
-		short int** array1 = ga1->array;
-		short int** array2 = ga2->array;
+		gol_grid grid1 = gol_array_grid(ga1);
+		gol_grid grid2 = gol_array_grid(ga2);
 
 		for (i=0; i<N; i++)
 		{
-			for (j=0; j<M; j++)
+			//for each row of cells/organisms
+			//see if there is a change
+			//populate_row applies the game's rules
+			//and returns the number of cells that changed
+			if (populate_row(grid1, grid2, i, 0, M - 1, NULL) != 0)
 			{
-				//for each cell/organism
-				//see if there is a change
-				//populate functions applies the game's rules
-				//and returns 0 if a change occurs
-				if (populate(array1, array2, N, M, i, j) == 0)
-				{
-					no_change = 0;
-				}
+				no_change = 0;
 			}
 		}
 
 		if (PRINT_STEPS)
 		{
-			print_array(array2, N, M);
+			print_array(ga2->array, N, M);
 			putchar('\n');
 		}
 
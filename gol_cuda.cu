@@ -25,24 +25,24 @@
 #define CUDA_THREADS 4
 #define CUDA_BLOCKS 64
 
-void print_1d_array(short int * array, int N, int M);
+void print_1d_array(gol_cell * array, int N, int M);
 
-__global__ void parallel_populate(short int* array1, short int* array2, int N, int M, int *no_change)
+__global__ void parallel_populate(gol_cell* array1, gol_cell* array2, int N, int M, int *no_change)
 {
 
-  uint worldSize = N * M;
+  size_t worldSize = (size_t) N * M;
 
   //Κάθε GPU thread παίρνει ένα κέλι με την σειρά
-  for (uint cellId = __mul24(blockIdx.x, blockDim.x) + threadIdx.x;
+  for (size_t cellId = (size_t) blockIdx.x * blockDim.x + threadIdx.x;
       cellId < worldSize;
-      cellId += blockDim.x * gridDim.x) {
-
-    uint x = cellId % N;
-    uint yAbs = cellId - x;
-    uint xLeft = (x + N - 1) % N;
-    uint xRight = (x + 1) % N;
-    uint yAbsUp = (yAbs + worldSize - N) % worldSize;
-    uint yAbsDown = (yAbs + N) % worldSize;
+      cellId += (size_t) blockDim.x * gridDim.x) {
+
+    size_t x = cellId % N;
+    size_t yAbs = cellId - x;
+    size_t xLeft = (x + N - 1) % N;
+    size_t xRight = (x + 1) % N;
+    size_t yAbsUp = (yAbs + worldSize - N) % worldSize;
+    size_t yAbsDown = (yAbs + N) % worldSize;
  
     uint alive = array1[xLeft + yAbsUp] + array1[x + yAbsUp]
       + array1[xRight + yAbsUp] + array1[xLeft + yAbs] + array1[xRight + yAbs]
@@ -189,19 +189,19 @@ int main(int argc, char* argv[])
 	}
 	
 	
-	short int* arr1;
-	short int* arr2;
+	gol_cell* arr1;
+	gol_cell* arr2;
 	int *cudaNoChange;
 
 	cudaMalloc((void **) &cudaNoChange, sizeof(int *));
-	cudaMalloc((void **) &arr1, N*M*sizeof(short int *));
-	cudaMalloc((void **) &arr2, N*M*sizeof(short int *));
+	cudaMalloc((void **) &arr1, (size_t) N*M*sizeof(gol_cell *));
+	cudaMalloc((void **) &arr2, (size_t) N*M*sizeof(gol_cell *));
 	
-	short int* oneDarray1 = (short int *) malloc(N*M*sizeof(short int));
-	short int* oneDarray2 = (short int *) malloc(N*M*sizeof(short int));
+	gol_cell* oneDarray1 = (gol_cell *) malloc((size_t) N*M*sizeof(gol_cell));
+	gol_cell* oneDarray2 = (gol_cell *) malloc((size_t) N*M*sizeof(gol_cell));
 		
 
-	cudaMemcpy(arr1, ga1->flat_array, sizeof(short int) * M * N, cudaMemcpyHostToDevice);
+	cudaMemcpy(arr1, ga1->flat_array, sizeof(gol_cell) * M * (size_t) N, cudaMemcpyHostToDevice);
 
 	int count;
 
@@ -217,7 +217,7 @@ int main(int argc, char* argv[])
 		print_1d_array(oneDarray1, N,M);
 		putchar('\n');
 	}
-	cudaMemcpy(oneDarray1, arr1, sizeof(short int) * M * N, cudaMemcpyDeviceToHost);
+	cudaMemcpy(oneDarray1, arr1, sizeof(gol_cell) * M * (size_t) N, cudaMemcpyDeviceToHost);
 
 
 	for(count = 0; count < max_loops; count++) 
@@ -227,14 +227,14 @@ int main(int argc, char* argv[])
 		//Copy the to arrays and the no_change variable to cuda Device
 		cudaMemcpy(cudaNoChange, no_change, sizeof(int), cudaMemcpyHostToDevice);
 
-		cudaMemcpy(arr1, oneDarray1, sizeof(short int) * M * N, cudaMemcpyHostToDevice);
-		cudaMemcpy(arr2, oneDarray2, sizeof(short int) * M * N, cudaMemcpyHostToDevice);
+		cudaMemcpy(arr1, oneDarray1, sizeof(gol_cell) * M * (size_t) N, cudaMemcpyHostToDevice);
+		cudaMemcpy(arr2, oneDarray2, sizeof(gol_cell) * M * (size_t) N, cudaMemcpyHostToDevice);
 
 		parallel_populate<<<cudaBlocks,cudaThreads>>>(arr1,  arr2, N,  M, cudaNoChange);
 
 		//Copy the to arrays and the no_change variable back to CPU memory
-		cudaMemcpy(oneDarray1, arr1, sizeof(short int) * M * N, cudaMemcpyDeviceToHost);
-		cudaMemcpy(oneDarray2, arr2, sizeof(short int) * M * N, cudaMemcpyDeviceToHost);
+		cudaMemcpy(oneDarray1, arr1, sizeof(gol_cell) * M * (size_t) N, cudaMemcpyDeviceToHost);
+		cudaMemcpy(oneDarray2, arr2, sizeof(gol_cell) * M * (size_t) N, cudaMemcpyDeviceToHost);
 		
 		cudaMemcpy(no_change, cudaNoChange, sizeof(int), cudaMemcpyDeviceToHost);
 
@@ -253,7 +253,7 @@ int main(int argc, char* argv[])
 		}
 
 		//swap arrays (array2 becomes array1)
-		short int* temp;
+		gol_cell* temp;
 		temp = oneDarray1;
 		oneDarray1 = oneDarray2;
 		oneDarray2 = temp;
@@ -295,10 +295,10 @@ gol_array* gol_array_init(int lines, int columns)
 {
 	//allocate one big flat array, so as to make sure that the memory is continuous
 	//in our 2 dimensional array
-	short int* flat_array = (short int*) calloc(lines*columns, sizeof(short int));
+	gol_cell* flat_array = (gol_cell*) calloc((size_t) lines*columns, sizeof(gol_cell));
 	assert(flat_array != NULL);
 
-	short int** array = (short int**) malloc(lines*sizeof(short int*));
+	gol_cell** array = (gol_cell**) malloc(lines*sizeof(gol_cell*));
 	assert(array != NULL);
 	int i;
 
@@ -306,7 +306,7 @@ gol_array* gol_array_init(int lines, int columns)
 	
 	for (i=0; i<lines; i++)
 	{
-		array[i] = &(flat_array[columns*i]);
+		array[i] = &(flat_array[(size_t) columns*i]);
 	}
 
 	//allocate gol_array struct
@@ -331,14 +331,14 @@ void gol_array_free(gol_array** gol_ar)
 
 void gol_array_read_file(char* filename, gol_array* gol_ar)
 {
-	short int** array = gol_ar->array;
+	gol_cell** array = gol_ar->array;
 	int N = gol_ar->lines;
 	int M = gol_ar->columns;
 
 	char line[100];
 	char copy[100];
-	int counter = 0;
-	int successful = 0;
+	long counter = 0;
+	long successful = 0;
 
 	FILE* file = fopen(filename, "r");
 
@@ -372,7 +372,7 @@ void gol_array_read_file(char* filename, gol_array* gol_ar)
 
 		if (token == NULL)
 		{
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -383,7 +383,7 @@ void gol_array_read_file(char* filename, gol_array* gol_ar)
 
 		if (token == NULL)
 		{
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -393,7 +393,7 @@ void gol_array_read_file(char* filename, gol_array* gol_ar)
 		if (row < 1 || row > N || col < 1 || col > M)
 		{
 			printf("Invalid row or column\n");
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -401,7 +401,7 @@ void gol_array_read_file(char* filename, gol_array* gol_ar)
 		array[row-1][col-1] = 1;
 	}
 
-	printf("\nSuccesfully read %d coordinates\n", successful);
+	printf("\nSuccesfully read %ld coordinates\n", successful);
 	fclose(file);
 }
 
@@ -422,13 +422,14 @@ void gol_array_generate(gol_array* gol_ar)
 		exit(-1);
 	}
 
-	short int** array = gol_ar->array;
+	gol_cell** array = gol_ar->array;
 	int lines = gol_ar->lines;
 	int columns = gol_ar->columns;
 
 	srand(time(NULL));
-	int alive_count = rand() % (lines*columns + 1);
-	int i;
+	//(two rand() calls, the board can have more cells than RAND_MAX)
+	long alive_count = ((long) rand() * ((long) RAND_MAX + 1) + rand()) % ((long) lines*columns + 1);
+	long i;
 
 	for (i=0; i<alive_count; i++)
 	{
@@ -443,7 +444,7 @@ void gol_array_generate(gol_array* gol_ar)
 	fclose(file);
 }
 
-void print_1d_array(short int * array, int N, int M)
+void print_1d_array(gol_cell * array, int N, int M)
 {
 	int i, j;
 	for (i=0; i<N; i++)
@@ -451,7 +452,7 @@ void print_1d_array(short int * array, int N, int M)
 		putchar('|');
 		for (j=0; j<M; j++)
 		{
-			if (array[i*M+j] == 1)
+			if (array[(size_t) i*M+j] == 1)
 				putchar('o');
 			else
 				putchar(' ');
@@ -462,7 +463,7 @@ void print_1d_array(short int * array, int N, int M)
 	}	
 }
 
-void print_array(short int** array, int N, int M)
+void print_array(gol_cell** array, int N, int M)
 {
 	int i, j;
 	for (i=0; i<N; i++)
@@ -1,7 +1,7 @@
 #include "functions.h"
 
 
-void print_array(short int** array, int N, int M)
+void print_array(gol_cell** array, int N, int M)
 {
 	int i, j;
 
@@ -24,7 +24,7 @@ void print_array(short int** array, int N, int M)
 }
 
 
-int populate(short int** array1, short int** array2, int N, int M, int i, int j)
+int populate(gol_cell** array1, gol_cell** array2, int N, int M, int i, int j)
 {
 	int no_change;
 	//get the number of neighbours
@@ -61,7 +61,98 @@ int populate(short int** array1, short int** array2, int N, int M, int i, int j)
 }
 
 
-int num_of_neighbours(short int** array, int N, int M, int row, int col)
+//the game's rules for cells [col_first, col_last] of a row, on the grids (the edges of the grid wrap around,
+//as in populate). The columns that do not wrap are one branch free loop the compiler can vectorize.
+//returns the number of cells that changed, and adds 1 to changed_cols[j] (if not NULL) for each one of them
+int populate_row(gol_grid current, gol_grid next, int row, int col_first, int col_last, int* changed_cols)
+{
+	int lines = current.lines;
+	int columns = current.columns;
+	const gol_cell* restrict up = gol_grid_row(current, (row - 1 + lines) % lines);
+	const gol_cell* restrict middle = gol_grid_row(current, row);
+	const gol_cell* restrict down = gol_grid_row(current, (row + 1) % lines);
+	gol_cell* restrict out = gol_grid_row(next, row);
+	int first = (col_first < 1) ? 1 : col_first;
+	int last = (col_last > columns - 2) ? columns - 2 : col_last;
+	int changes = 0;
+	int j;
+
+	for (j = first; j <= last; j++)
+	{
+		int neighbours = up[j-1] + up[j] + up[j+1] + middle[j-1] + middle[j+1] + down[j-1] + down[j] + down[j+1];
+		gol_cell alive = (neighbours == 3) | ((neighbours == 2) & (middle[j] == 1));
+		out[j] = alive;
+		changes += (alive != middle[j]);
+	}
+
+	if (changed_cols != NULL && changes > 0)
+	{
+		for (j = first; j <= last; j++)
+			changed_cols[j] += (out[j] != middle[j]);
+	}
+
+	//the columns whose left/right neighbours wrap around: up to the first one, and from the last one on
+	//(a process' block can have cols past the game's last one, that wrap like they would in populate)
+	for (j = col_first; j <= col_last; j++)
+	{
+		if (j == first && first <= last)
+			j = last + 1;
+		if (j > col_last)
+			break;
+
+		int left = (j - 1 + columns) % columns;
+		int right = (j + 1) % columns;
+		int neighbours = up[left] + up[j] + up[right] + middle[left] + middle[right] + down[left] + down[j] + down[right];
+		gol_cell alive = (neighbours == 3) | ((neighbours == 2) & (middle[j] == 1));
+		out[j] = alive;
+
+		if (alive != middle[j])
+		{
+			changes++;
+			if (changed_cols != NULL)
+				changed_cols[j]++;
+		}
+	}
+
+	return changes;
+}
+
+
+//populate_row down a column: cells [row_first, row_last] of col, a stride apart on the grids
+//(for the left/right edges of a block, whose cells are not contiguous)
+//returns the number of cells that changed, and adds 1 to changed_rows[i] (if not NULL) for each one of them
+int populate_col(gol_grid current, gol_grid next, int col, int row_first, int row_last, int* changed_rows)
+{
+	int lines = current.lines;
+	int columns = current.columns;
+	int left = (col - 1 + columns) % columns;
+	int right = (col + 1) % columns;
+	int changes = 0;
+	int i;
+
+	for (i = row_first; i <= row_last; i++)
+	{
+		const gol_cell* restrict up = gol_grid_row(current, (i - 1 + lines) % lines);
+		const gol_cell* restrict middle = gol_grid_row(current, i);
+		const gol_cell* restrict down = gol_grid_row(current, (i + 1) % lines);
+		int neighbours = up[left] + up[col] + up[right] + middle[left] + middle[right] + down[left] + down[col] + down[right];
+		gol_cell alive = (neighbours == 3) | ((neighbours == 2) & (middle[col] == 1));
+
+		*gol_grid_cell(next, i, col) = alive;
+
+		if (alive != middle[col])
+		{
+			changes++;
+			if (changed_rows != NULL)
+				changed_rows[i]++;
+		}
+	}
+
+	return changes;
+}
+
+
+int num_of_neighbours(gol_cell** array, int N, int M, int row, int col)
 {
 	int up_row = (row-1+N) % N;
 	int down_row = (row+1) % N;
@@ -89,7 +180,7 @@ int num_of_neighbours(short int** array, int N, int M, int row, int col)
 }
 
 
-void print_neighbour_nums(short int** array, int N, int M)
+void print_neighbour_nums(gol_cell** array, int N, int M)
 {
 	int i,j;
 
@@ -108,37 +199,30 @@ void get_date_time_str(char* datestr, char* timestr)
 {
 	time_t t = time(NULL);
 	struct tm tm = *localtime(&t);
-	char day[3];
-	char month[3];
-	char hour[3];
-	char minute[3];
-	char second[3];
-
-	if (tm.tm_mon + 1 > 9)
-		sprintf(month, "%d",tm.tm_mon + 1);
-	else
-		sprintf(month, "0%d",tm.tm_mon + 1);
-
-	if (tm.tm_mday > 9)
-		sprintf(day, "%d",tm.tm_mday);
-	else
-		sprintf(day, "0%d",tm.tm_mday);
-
-	if (tm.tm_hour > 9)
-		sprintf(hour, "%d",tm.tm_hour);
-	else
-		sprintf(hour, "0%d",tm.tm_hour);
-
-	if (tm.tm_min > 9)
-		sprintf(minute, "%d",tm.tm_min);
-	else
-		sprintf(minute, "0%d",tm.tm_min);
-
-	if (tm.tm_sec > 9)
-		sprintf(second, "%d",tm.tm_sec);
-	else
-		sprintf(second, "0%d",tm.tm_sec);
+	//sized for any int, the fields are always 2 digits
+	char day[12];
+	char month[12];
+	char hour[12];
+	char minute[12];
+	char second[12];
+
+	snprintf(month, sizeof month, "%02d", tm.tm_mon + 1);
+	snprintf(day, sizeof day, "%02d", tm.tm_mday);
+	snprintf(hour, sizeof hour, "%02d", tm.tm_hour);
+	snprintf(minute, sizeof minute, "%02d", tm.tm_min);
+	snprintf(second, sizeof second, "%02d", tm.tm_sec);
 
 	sprintf(datestr, "%d%s%s", tm.tm_year + 1900, month, day);
 	sprintf(timestr, "%s%s%s", hour, minute, second);
-}
\ No newline at end of file
+}
+
+
+//a random number in [0, n)
+//rand() % n while n fits in rand() (so seeded games stay the same), else made of two rand() calls
+long random_below(long n)
+{
+	if (n <= (long) RAND_MAX + 1)
+		return rand() % n;
+
+	return (((long) rand() * ((long) RAND_MAX + 1)) + rand()) % n;
+}
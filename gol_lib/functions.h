@@ -6,10 +6,13 @@
 #include <string.h>
 #include "gol_array.h"
 
-void print_array(short int** array, int N, int M);
-int populate(short int** array1, short int** array2, int N, int M, int i, int j);
-int num_of_neighbours(short int** array, int N, int M, int row, int col);
-void print_neighbour_nums(short int** array, int N, int M);
+void print_array(gol_cell** array, int N, int M);
+int populate(gol_cell** array1, gol_cell** array2, int N, int M, int i, int j);
+int populate_row(gol_grid current, gol_grid next, int row, int col_first, int col_last, int* changed_cols);
+int populate_col(gol_grid current, gol_grid next, int col, int row_first, int row_last, int* changed_rows);
+int num_of_neighbours(gol_cell** array, int N, int M, int row, int col);
+void print_neighbour_nums(gol_cell** array, int N, int M);
 void get_date_time_str(char* datestr, char* timestr);
+long random_below(long n);
 
 #endif
\ No newline at end of file
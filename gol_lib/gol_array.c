@@ -1,14 +1,107 @@
+#define _GNU_SOURCE
+#include <sys/mman.h>
 #include "gol_array.h"
 #include "functions.h"
 
+static gol_array* wrap_strided(gol_cell* flat_array, int lines, int columns, int stride);
+
 gol_array* gol_array_init(int lines, int columns)
 {
 	//allocate one big flat array, so as to make sure that the memory is continuous
 	//in our 2 dimensional array
-	short int* flat_array = calloc(lines*columns, sizeof(short int));
+	gol_cell* flat_array = calloc((size_t) lines*columns, sizeof(gol_cell));
 	assert(flat_array != NULL);
 
-	short int** array = malloc(lines*sizeof(short int*));
+	gol_array* new_gol_array = gol_array_wrap(flat_array, lines, columns);
+	new_gol_array->owns_memory = 1;
+
+	return new_gol_array;
+}
+
+
+
+int gol_array_padded_stride(int columns)
+{
+	//round a row up to whole cache lines, then add one more line if the row is a power of two
+	//or a multiple of 4K bytes, so that the 3 rows a cell reads do not map to the same cache sets
+	int line = GOL_ARRAY_ALIGNMENT / sizeof(gol_cell);
+	int stride = (columns + line - 1) / line * line;
+	long bytes = (long) stride * sizeof(gol_cell);
+
+	if ((bytes & (bytes - 1)) == 0 || bytes % 4096 == 0)
+		stride += line;
+
+	return stride;
+}
+
+
+
+void gol_array_init_arena(int lines, int columns, int zero, gol_array** ga1, gol_array** ga2)
+{
+	//both game arrays in one allocation, every row aligned to a cache line and padded (gol_array_padded_stride)
+	//Arenas of at least a huge page are mmap'ed, from the huge page pool if there is one,
+	//else as transparent huge pages. Their pages are zero, and only placed when first written,
+	//so with zero == 0 the threads can first touch their own rows (NUMA first touch): each thread
+	//should then zero the rows it will be computing
+	int stride = gol_array_padded_stride(columns);
+	size_t array_size = (size_t) lines * stride * sizeof(gol_cell);
+	size_t size = 2 * array_size;
+	gol_arena* arena = malloc(sizeof(gol_arena));
+	assert(arena != NULL);
+
+	arena->memory = NULL;
+	arena->mapped = 0;
+	arena->users = 2;
+
+	if (size >= GOL_ARRAY_HUGE_PAGE)
+	{
+		size = (size + GOL_ARRAY_HUGE_PAGE - 1) / GOL_ARRAY_HUGE_PAGE * GOL_ARRAY_HUGE_PAGE;
+
+		arena->memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (arena->memory == MAP_FAILED)
+		{
+			arena->memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (arena->memory != MAP_FAILED)
+				madvise(arena->memory, size, MADV_HUGEPAGE);
+		}
+
+		if (arena->memory == MAP_FAILED)
+			arena->memory = NULL;
+		else
+			arena->mapped = 1;
+	}
+
+	if (arena->memory == NULL)
+	{
+		int ret = posix_memalign(&arena->memory, GOL_ARRAY_ALIGNMENT, size);
+		assert(ret == 0);
+
+		if (zero)
+			memset(arena->memory, 0, size);
+	}
+
+	arena->size = size;
+
+	*ga1 = wrap_strided((gol_cell*) arena->memory, lines, columns, stride);
+	*ga2 = wrap_strided((gol_cell*) ((char*) arena->memory + array_size), lines, columns, stride);
+	(*ga1)->arena = arena;
+	(*ga2)->arena = arena;
+}
+
+
+
+gol_array* gol_array_wrap(gol_cell* flat_array, int lines, int columns)
+{
+	//use a flat array that was allocated by someone else (e.g. an MPI shared memory window)
+	//gol_array_free will not free it
+	return wrap_strided(flat_array, lines, columns, columns);
+}
+
+
+
+static gol_array* wrap_strided(gol_cell* flat_array, int lines, int columns, int stride)
+{
+	gol_cell** array = malloc(lines*sizeof(gol_cell*));
 	assert(array != NULL);
 	int i;
 
@@ -16,7 +109,7 @@ gol_array* gol_array_init(int lines, int columns)
 	
 	for (i=0; i<lines; i++)
 	{
-		array[i] = &(flat_array[columns*i]);
+		array[i] = &(flat_array[(size_t) stride*i]);
 	}
 
 	//allocate gol_array struct
@@ -25,6 +118,9 @@ gol_array* gol_array_init(int lines, int columns)
 	new_gol_array->array = array;
 	new_gol_array->lines = lines;
 	new_gol_array->columns = columns;
+	new_gol_array->stride = stride;
+	new_gol_array->owns_memory = 0;
+	new_gol_array->arena = NULL;
 
 	return new_gol_array;
 }
@@ -34,8 +130,21 @@ gol_array* gol_array_init(int lines, int columns)
 void gol_array_free(gol_array** gol_ar)
 {
 	gol_array* gol_ar_ptr = *gol_ar;
+	gol_arena* arena = gol_ar_ptr->arena;
+
+	if (gol_ar_ptr->owns_memory)
+		free(gol_ar_ptr->flat_array);
+
+	//the arena goes with the second array of the pair
+	if (arena != NULL && --arena->users == 0)
+	{
+		if (arena->mapped)
+			munmap(arena->memory, arena->size);
+		else
+			free(arena->memory);
+		free(arena);
+	}
 
-	free(gol_ar_ptr->flat_array);
 	free(gol_ar_ptr->array);
 	free(*gol_ar);
 	*gol_ar = NULL;
@@ -45,7 +154,7 @@ void gol_array_free(gol_array** gol_ar)
 
 void gol_array_read_input(gol_array* gol_ar)
 {
-	short int** array = gol_ar->array;
+	gol_cell** array = gol_ar->array;
 	int N = gol_ar->lines;
 	int M = gol_ar->columns;
 
@@ -84,14 +193,14 @@ void gol_array_read_input(gol_array* gol_ar)
 
 void gol_array_read_file(char* filename, gol_array* gol_ar)
 {
-	short int** array = gol_ar->array;
+	gol_cell** array = gol_ar->array;
 	int N = gol_ar->lines;
 	int M = gol_ar->columns;
 
 	char line[100];
 	char copy[100];
-	int counter = 0;
-	int successful = 0;
+	long counter = 0;
+	long successful = 0;
 
 	FILE* file = fopen(filename, "r");
 
@@ -125,7 +234,7 @@ void gol_array_read_file(char* filename, gol_array* gol_ar)
 
 		if (token == NULL)
 		{
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -136,7 +245,7 @@ void gol_array_read_file(char* filename, gol_array* gol_ar)
 
 		if (token == NULL)
 		{
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -146,7 +255,7 @@ void gol_array_read_file(char* filename, gol_array* gol_ar)
 		if (row < 1 || row > N || col < 1 || col > M)
 		{
 			printf("Invalid row or column\n");
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -154,7 +263,7 @@ void gol_array_read_file(char* filename, gol_array* gol_ar)
 		array[row-1][col-1] = 1;
 	}
 
-	printf("\nSuccesfully read %d coordinates\n", successful);
+	printf("\nSuccesfully read %ld coordinates\n", successful);
 	fclose(file);
 }
 
@@ -175,13 +284,13 @@ void gol_array_generate(gol_array* gol_ar)
 		exit(-1);
 	}
 
-	short int** array = gol_ar->array;
+	gol_cell** array = gol_ar->array;
 	int lines = gol_ar->lines;
 	int columns = gol_ar->columns;
 
 	srand(time(NULL));
-	int alive_count = rand() % (lines*columns + 1);
-	int i;
+	long alive_count = random_below((long) lines*columns + 1);
+	long i;
 
 	for (i=0; i<alive_count; i++)
 	{
@@ -6,19 +6,89 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <time.h>
-#include "functions.h"
+#include <stdint.h>
+
+#define GOL_ARRAY_ALIGNMENT 64 //cache line, every row of an arena starts on one
+#define GOL_ARRAY_HUGE_PAGE (2*1024*1024) //arenas this big are mapped on huge pages
+#define GOL_CELL_BYTE 0 //1 to store a cell (0 or 1) in a byte instead of a short int, for all the programs
+
+//the type of a cell, and the MPI datatype the halos, scatter and gather use for it
+//(a byte halves the memory and the halo bandwidth, and lets the kernels work on more cells per vector)
+#if GOL_CELL_BYTE
+typedef uint8_t gol_cell;
+#define GOL_CELL_MPI MPI_UINT8_T
+#else
+typedef short int gol_cell;
+#define GOL_CELL_MPI MPI_SHORT
+#endif
+
+//the memory both game arrays of a gol_array_init_arena pair live in
+struct gol_arena
+{
+	void* memory;
+	size_t size;
+	int mapped; //1 if it was mmap'ed, 0 if it came from posix_memalign
+	int users; //gol_arrays not freed yet
+};
+
+typedef struct gol_arena gol_arena;
 
 struct gol_array
 {
-	short int* flat_array;
-	short int** array;
+	gol_cell* flat_array;
+	gol_cell** array;
 	int lines;
 	int columns;
+	int stride; //cells from the start of a row to the next, == columns unless it comes from an arena
+	int owns_memory; //0 if flat_array was allocated elsewhere (gol_array_wrap)
+	gol_arena* arena; //NULL unless it comes from gol_array_init_arena
 };
 
 typedef struct gol_array gol_array;
 
+//a view of a gol_array's cells without the row pointer table: cell (i, j) is cells[i*stride + j]
+//Kernels take these (by value) so that a cell is one load, and mark the pointers they get from them restrict
+struct gol_grid
+{
+	gol_cell* cells;
+	int lines; //where the rows and cols wrap around
+	int columns;
+	int stride;
+};
+
+typedef struct gol_grid gol_grid;
+
+static inline gol_grid gol_array_grid(gol_array* gol_ar)
+{
+	gol_grid grid = { gol_ar->flat_array, gol_ar->lines, gol_ar->columns, gol_ar->stride };
+	return grid;
+}
+
+//a view of a process' block, whose cells wrap around like those of the whole lines x columns game
+//(as populate does when it is given the game's N, M)
+static inline gol_grid gol_array_block_grid(gol_array* gol_ar, int lines, int columns)
+{
+	gol_grid grid = { gol_ar->flat_array, lines, columns, gol_ar->stride };
+	return grid;
+}
+
+static inline gol_cell* gol_grid_row(gol_grid grid, int row)
+{
+	return grid.cells + (size_t) row * grid.stride;
+}
+
+static inline gol_cell* gol_grid_cell(gol_grid grid, int row, int col)
+{
+	return grid.cells + (size_t) row * grid.stride + col;
+}
+
+//after the types, functions.h needs them (and includes us)
+#include "functions.h"
+
 gol_array* gol_array_init(int lines, int columns);
+void gol_array_init_arena(int lines, int columns, int zero, gol_array** ga1, gol_array** ga2);
+int gol_array_padded_stride(int columns);
+gol_array* gol_array_wrap(gol_cell* flat_array, int lines, int columns);
 void gol_array_free(gol_array** gol_ar);
 void gol_array_read_input(gol_array* gol_ar);
 void gol_array_read_file(char* filename, gol_array* gol_ar);
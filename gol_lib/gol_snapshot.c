@@ -0,0 +1,292 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gol_snapshot.h"
+#include "functions.h"
+
+static gol_snapshot* map_snapshot(int fd, int writable, size_t size);
+
+
+gol_snapshot* gol_snapshot_create(char* filename, int lines, int columns)
+{
+	//a new file of dead cells (the file is sparse, its pages are only allocated when written)
+	size_t row_bytes = ((size_t) columns + 8*GOL_SNAPSHOT_WORD - 1) / (8*GOL_SNAPSHOT_WORD) * GOL_SNAPSHOT_WORD;
+	size_t size = GOL_SNAPSHOT_DATA + (size_t) lines * row_bytes;
+	int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if (fd == -1 || ftruncate(fd, size) == -1)
+	{
+		printf("Error creating snapshot '%s'\n", filename);
+		if (fd != -1)
+			close(fd);
+		return NULL;
+	}
+
+	gol_snapshot* snap = map_snapshot(fd, 1, size);
+	if (snap == NULL)
+		return NULL;
+
+	memcpy(snap->header->magic, GOL_SNAPSHOT_MAGIC, 8);
+	snap->header->lines = lines;
+	snap->header->columns = columns;
+	snap->header->generation = 0;
+	snap->header->row_bytes = row_bytes;
+	snap->lines = lines;
+	snap->columns = columns;
+	snap->row_bytes = row_bytes;
+
+	return snap;
+}
+
+
+
+gol_snapshot* gol_snapshot_open(char* filename, int writable)
+{
+	struct stat st;
+	int fd = open(filename, writable ? O_RDWR : O_RDONLY);
+
+	if (fd == -1 || fstat(fd, &st) == -1 || st.st_size < GOL_SNAPSHOT_DATA)
+	{
+		printf("Error opening snapshot '%s'\n", filename);
+		if (fd != -1)
+			close(fd);
+		return NULL;
+	}
+
+	gol_snapshot* snap = map_snapshot(fd, writable, st.st_size);
+	if (snap == NULL)
+		return NULL;
+
+	gol_snapshot_header* header = snap->header;
+
+	if (memcmp(header->magic, GOL_SNAPSHOT_MAGIC, 8) != 0 || header->lines <= 0 || header->lines > INT_MAX
+		|| header->columns <= 0 || header->columns > INT_MAX || header->row_bytes * 8 < header->columns
+		|| (size_t) GOL_SNAPSHOT_DATA + header->lines * header->row_bytes > snap->size)
+	{
+		printf("'%s' is not a game of life snapshot\n", filename);
+		gol_snapshot_close(&snap);
+		return NULL;
+	}
+
+	snap->lines = header->lines;
+	snap->columns = header->columns;
+	snap->row_bytes = header->row_bytes;
+
+	return snap;
+}
+
+
+
+static gol_snapshot* map_snapshot(int fd, int writable, size_t size)
+{
+	uint8_t* map = mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+
+	if (map == MAP_FAILED)
+	{
+		printf("Error mapping snapshot\n");
+		close(fd);
+		return NULL;
+	}
+
+	//the engines go through the rows in order
+	madvise(map, size, MADV_SEQUENTIAL);
+
+	gol_snapshot* snap = malloc(sizeof(gol_snapshot));
+	assert(snap != NULL);
+
+	snap->fd = fd;
+	snap->writable = writable;
+	snap->size = size;
+	snap->map = map;
+	snap->header = (gol_snapshot_header*) map;
+	snap->rows = map + GOL_SNAPSHOT_DATA;
+
+	return snap;
+}
+
+
+
+void gol_snapshot_close(gol_snapshot** snap)
+{
+	gol_snapshot* snap_ptr = *snap;
+
+	munmap(snap_ptr->map, snap_ptr->size);
+	close(snap_ptr->fd);
+	free(snap_ptr);
+	*snap = NULL;
+}
+
+
+
+void gol_snapshot_unpack_row(gol_snapshot* snap, int row, gol_cell* cells)
+{
+	const uint8_t* bits = gol_snapshot_row(snap, row);
+	int j;
+
+	for (j=0; j<snap->columns; j++)
+		cells[j] = (bits[j / 8] >> (j % 8)) & 1;
+}
+
+
+
+void gol_snapshot_pack_row(gol_snapshot* snap, int row, const gol_cell* cells)
+{
+	uint8_t* bits = gol_snapshot_row(snap, row);
+	int columns = snap->columns;
+	int j, b;
+
+	for (j=0; j<columns; j+=8)
+	{
+		uint8_t byte = 0;
+
+		for (b=0; b<8 && j + b < columns; b++)
+			byte |= (cells[j + b] & 1) << b;
+
+		bits[j / 8] = byte;
+	}
+}
+
+
+
+void gol_snapshot_release_rows(gol_snapshot* snap, int first, int last)
+{
+	//the engines are done with rows first..last: start writing them back (if we wrote them)
+	//and drop their pages, so that only the rows being worked on stay in memory
+	//(the pages the range only partly covers are kept)
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t start = GOL_SNAPSHOT_DATA + (size_t) first * snap->row_bytes;
+	size_t end = GOL_SNAPSHOT_DATA + (size_t) (last + 1) * snap->row_bytes;
+
+	start = (start + page - 1) / page * page;
+	end = end / page * page;
+
+	if (first > last || start >= end)
+		return;
+
+	if (snap->writable)
+		msync(snap->map + start, end - start, MS_ASYNC);
+	madvise(snap->map + start, end - start, MADV_DONTNEED);
+}
+
+
+
+long gol_snapshot_read_file(char* filename, gol_snapshot* snap)
+{
+	//the same coordinates files as gol_array_read_file, written straight into the snapshot
+	int N = snap->lines;
+	int M = snap->columns;
+
+	char line[100];
+	long counter = 0;
+	long successful = 0;
+
+	FILE* file = fopen(filename, "r");
+
+	if (file == NULL)
+	{
+		printf("Error opening file\n");
+		return -1;
+	}
+
+	while (fgets(line, 100, file) != NULL)
+	{
+		counter++;
+
+		/*ignore blank lines or lines that start with '#'*/
+		if (strlen(line) == 0 || line[0] == '#')
+			continue;
+
+		int row, col;
+
+		//the line should contain just 2 numbers, the coordinates (row column) of an alive organism/cell
+		if (sscanf(line, "%d %d", &row, &col) != 2 || row < 1 || row > N || col < 1 || col > M)
+		{
+			printf("Skipping invalid line (%ld): '%s'\n", counter, line);
+			continue;
+		}
+
+		successful++;
+		gol_snapshot_set(snap, row - 1, col - 1);
+	}
+
+	fclose(file);
+	return successful;
+}
+
+
+
+void gol_snapshot_generate(gol_snapshot* snap)
+{
+	srand(time(NULL));
+	long alive_count = random_below((long) snap->lines*snap->columns + 1);
+	long i;
+
+	for (i=0; i<alive_count; i++)
+	{
+		int x = rand() % snap->lines;
+		int y = rand() % snap->columns;
+
+		gol_snapshot_set(snap, x, y);
+	}
+}
+
+
+
+void gol_snapshot_print(gol_snapshot* snap)
+{
+	//as print_array, a row at a time
+	gol_cell* cells = malloc(snap->columns * sizeof(gol_cell));
+	assert(cells != NULL);
+	int i;
+
+	for (i=0; i<snap->lines; i++)
+	{
+		gol_snapshot_unpack_row(snap, i, cells);
+		print_array(&cells, 1, snap->columns);
+	}
+
+	free(cells);
+}
+
+
+
+void gol_snapshot_read_array(char* filename, gol_array* gol_ar)
+{
+	//load a snapshot into an (in memory) game array of the same size
+	gol_snapshot* snap = gol_snapshot_open(filename, 0);
+	int i;
+
+	if (snap == NULL)
+		return;
+
+	if (snap->lines != gol_ar->lines || snap->columns != gol_ar->columns)
+	{
+		printf("Snapshot '%s' is %dx%d, not %dx%d\n", filename, snap->lines, snap->columns, gol_ar->lines, gol_ar->columns);
+		gol_snapshot_close(&snap);
+		return;
+	}
+
+	for (i=0; i<snap->lines; i++)
+		gol_snapshot_unpack_row(snap, i, gol_ar->array[i]);
+
+	gol_snapshot_close(&snap);
+}
+
+
+
+void gol_snapshot_write_array(char* filename, gol_array* gol_ar, long generation)
+{
+	gol_snapshot* snap = gol_snapshot_create(filename, gol_ar->lines, gol_ar->columns);
+	int i;
+
+	if (snap == NULL)
+		return;
+
+	for (i=0; i<snap->lines; i++)
+		gol_snapshot_pack_row(snap, i, gol_ar->array[i]);
+
+	snap->header->generation = generation;
+	gol_snapshot_close(&snap);
+}
@@ -0,0 +1,65 @@
+#ifndef GOL_SNAPSHOT_H
+#define GOL_SNAPSHOT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "gol_array.h"
+
+#define GOL_SNAPSHOT_MAGIC "GOLSNAP1"
+#define GOL_SNAPSHOT_DATA 4096 //the rows start on the first page after the header
+#define GOL_SNAPSHOT_WORD 8 //every row is padded to whole 64 bit words
+
+//a game saved on disk, one bit per cell (bit j%8 of byte j/8 of its row), memory mapped
+//The file is the header, then the rows at GOL_SNAPSHOT_DATA, row_bytes apart
+struct gol_snapshot_header
+{
+	char magic[8];
+	int64_t lines;
+	int64_t columns;
+	int64_t generation; //generations played since the game was created
+	int64_t row_bytes;
+};
+
+typedef struct gol_snapshot_header gol_snapshot_header;
+
+struct gol_snapshot
+{
+	int fd;
+	int writable;
+	size_t size; //of the file (and the mapping)
+	uint8_t* map;
+	gol_snapshot_header* header;
+	uint8_t* rows;
+	int lines;
+	int columns;
+	size_t row_bytes;
+};
+
+typedef struct gol_snapshot gol_snapshot;
+
+static inline uint8_t* gol_snapshot_row(gol_snapshot* snap, int row)
+{
+	return snap->rows + (size_t) row * snap->row_bytes;
+}
+
+static inline void gol_snapshot_set(gol_snapshot* snap, int row, int col)
+{
+	gol_snapshot_row(snap, row)[col / 8] |= 1 << (col % 8);
+}
+
+gol_snapshot* gol_snapshot_create(char* filename, int lines, int columns);
+gol_snapshot* gol_snapshot_open(char* filename, int writable);
+void gol_snapshot_close(gol_snapshot** snap);
+void gol_snapshot_unpack_row(gol_snapshot* snap, int row, gol_cell* cells);
+void gol_snapshot_pack_row(gol_snapshot* snap, int row, const gol_cell* cells);
+void gol_snapshot_release_rows(gol_snapshot* snap, int first, int last);
+long gol_snapshot_read_file(char* filename, gol_snapshot* snap);
+void gol_snapshot_generate(gol_snapshot* snap);
+void gol_snapshot_print(gol_snapshot* snap);
+void gol_snapshot_read_array(char* filename, gol_array* gol_ar);
+void gol_snapshot_write_array(char* filename, gol_array* gol_ar, long generation);
+
+#endif
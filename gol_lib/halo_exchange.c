@@ -0,0 +1,1081 @@
+#include "halo_exchange.h"
+
+//neighbour on the opposite side (what we send up, our up neighbour receives from down)
+static const int opposite[HALO_NEIGHBOURS] = { HALO_DOWN, HALO_UP, HALO_RIGHT, HALO_LEFT,
+	HALO_DOWN_RIGHT, HALO_DOWN_LEFT, HALO_UP_RIGHT, HALO_UP_LEFT };
+
+static const char* type_names[] = { "p2p", "neighbour", "shm", "rma", "delta", "async" };
+static const char* progress_names[] = { "none", "test", "thread" };
+
+//kinds of HALO_EXCHANGE_DELTA messages: int kind, int flips, then the flipped cells (ints) or the whole edge (gol_cells)
+#define DELTA_UNCHANGED 0
+#define DELTA_SPARSE 1
+#define DELTA_FULL 2
+#define DELTA_HEADER (2*sizeof(int))
+
+
+int halo_exchange_type_from_str(char* str)
+{
+	int i;
+
+	for (i=0; i<(int) (sizeof(type_names) / sizeof(type_names[0])); i++)
+	{
+		if ( !strcmp(str, type_names[i]) )
+			return i;
+	}
+
+	return -1;
+}
+
+
+const char* halo_exchange_type_str(int type)
+{
+	return type_names[type];
+}
+
+
+int halo_progress_from_str(char* str)
+{
+	int i;
+
+	for (i=0; i<(int) (sizeof(progress_names) / sizeof(progress_names[0])); i++)
+	{
+		if ( !strcmp(str, progress_names[i]) )
+			return i;
+	}
+
+	return -1;
+}
+
+
+const char* halo_progress_str(int progress)
+{
+	return progress_names[progress];
+}
+
+
+//first cell of the edge of a rows x cols block that has to be sent to the neighbour of direction dir
+static void send_position(int rows, int cols, int dir, int* row, int* col)
+{
+	int row_end = rows;
+	int col_end = cols;
+
+	*row = (dir == HALO_DOWN || dir == HALO_DOWN_LEFT || dir == HALO_DOWN_RIGHT) ? row_end : 1;
+	*col = (dir == HALO_RIGHT || dir == HALO_UP_RIGHT || dir == HALO_DOWN_RIGHT) ? col_end : 1;
+}
+
+
+//first cell of the halo (extra row/col) of a rows x cols block that is received from the neighbour of direction dir
+static void recv_position(int rows, int cols, int dir, int* row, int* col)
+{
+	int down_row = rows + 1;
+	int right_col = cols + 1;
+
+	switch (dir)
+	{
+		case HALO_UP:         *row = 0;        *col = 1;         break;
+		case HALO_DOWN:       *row = down_row; *col = 1;         break;
+		case HALO_LEFT:       *row = 1;        *col = 0;         break;
+		case HALO_RIGHT:      *row = 1;        *col = right_col; break;
+		case HALO_UP_LEFT:    *row = 0;        *col = 0;         break;
+		case HALO_UP_RIGHT:   *row = 0;        *col = right_col; break;
+		case HALO_DOWN_LEFT:  *row = down_row; *col = 0;         break;
+		case HALO_DOWN_RIGHT: *row = down_row; *col = right_col; break;
+	}
+}
+
+
+//rows are contiguous, cols use the column derived data type, corners are a single cell
+//(only the neighbourhood collective sends cols straight from the array, the others use the side buffers)
+static void edge_type(halo_exchange* hx, int dir, int* count, MPI_Datatype* type)
+{
+	if (dir == HALO_UP || dir == HALO_DOWN)
+	{
+		*count = hx->cols_per_block;
+		*type = GOL_CELL_MPI;
+	}
+	else if (dir == HALO_LEFT || dir == HALO_RIGHT)
+	{
+		*count = 1;
+		*type = hx->col_type;
+	}
+	else
+	{
+		*count = 1;
+		*type = GOL_CELL_MPI;
+	}
+}
+
+
+//Blocks might have different sizes (see repartitioning), so learn the size of every neighbour's block
+static void exchange_block_sizes(halo_exchange* hx)
+{
+	int size[2] = { hx->rows_per_block, hx->cols_per_block };
+	int neighbour_size[HALO_NEIGHBOURS][2];
+	MPI_Request requests[2*HALO_NEIGHBOURS];
+	int dir;
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		neighbour_size[dir][0] = hx->rows_per_block;
+		neighbour_size[dir][1] = hx->cols_per_block;
+		MPI_Irecv(neighbour_size[dir], 2, MPI_INT, hx->ranks[dir], opposite[dir] + 1, hx->comm, &requests[dir]);
+		MPI_Isend(size, 2, MPI_INT, hx->ranks[dir], dir + 1, hx->comm, &requests[HALO_NEIGHBOURS + dir]);
+	}
+
+	MPI_Waitall(2*HALO_NEIGHBOURS, requests, MPI_STATUSES_IGNORE);
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		hx->neighbour_rows[dir] = neighbour_size[dir][0];
+		hx->neighbour_cols[dir] = neighbour_size[dir][1];
+	}
+}
+
+
+//a contiguous edge copied to a col of the array (or the other way round)
+//the array side is strided, so the loops only promise the compiler that the two never overlap
+static void unpack_col(gol_cell* restrict col, int stride, const gol_cell* restrict edge, int n)
+{
+	int i;
+
+	for (i=0; i<n; i++)
+		col[(size_t) i*stride] = edge[i];
+}
+
+
+static void pack_col(gol_cell* restrict edge, const gol_cell* restrict col, int stride, int n)
+{
+	int i;
+
+	for (i=0; i<n; i++)
+		edge[i] = col[(size_t) i*stride];
+}
+
+
+//the left/right halos that arrived in their contiguous buffers, copied to the array
+static void unpack_side_halos(halo_exchange* hx, int communication_type)
+{
+	gol_grid grid = gol_array_grid(hx->arrays[communication_type]);
+	int dir, row, col;
+
+	for (dir=HALO_LEFT; dir<=HALO_RIGHT; dir++)
+	{
+		if (hx->ranks[dir] == MPI_PROC_NULL || (hx->type == HALO_EXCHANGE_SHM && hx->shared[dir]))
+			continue;
+
+		recv_position(hx->rows_per_block, hx->cols_per_block, dir, &row, &col);
+		unpack_col(gol_grid_cell(grid, row, col), grid.stride, hx->side_halos[communication_type][dir], hx->rows_per_block);
+	}
+}
+
+
+static void p2p_init(halo_exchange* hx)
+{
+	int b, dir, row, col, count;
+	MPI_Datatype type;
+
+	//We need to define two types of requests
+	//Because the send/receive buffer is changed due to swapping after each loop/generation
+	//Tags seperate the messages, since the up and the down neighbour might be the same process (or even ourselves..)
+	for (b=0; b<2; b++)
+	{
+		gol_grid grid = gol_array_grid(hx->arrays[b]);
+
+		for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+		{
+			edge_type(hx, dir, &count, &type);
+
+			//neighbours on our node only need an (empty) message to know that our block is ready
+			if (hx->type == HALO_EXCHANGE_SHM && hx->shared[dir])
+				count = 0;
+
+			//cols are sent from (and received into) contiguous buffers
+			if (dir == HALO_LEFT || dir == HALO_RIGHT)
+			{
+				count = (count == 0) ? 0 : hx->rows_per_block;
+				MPI_Send_init(hx->side_edges[b][dir], count, GOL_CELL_MPI, hx->ranks[dir], dir + 1, hx->comm, &hx->send_request[b][dir]);
+				MPI_Recv_init(hx->side_halos[b][dir], count, GOL_CELL_MPI, hx->ranks[dir], opposite[dir] + 1, hx->comm, &hx->recv_request[b][dir]);
+				continue;
+			}
+
+			send_position(hx->rows_per_block, hx->cols_per_block, dir, &row, &col);
+			MPI_Send_init( gol_grid_cell(grid, row, col), count, type, hx->ranks[dir], dir + 1, hx->comm, &hx->send_request[b][dir]);
+
+			//receive up what the up neighbour sent down etc
+			recv_position(hx->rows_per_block, hx->cols_per_block, dir, &row, &col);
+			MPI_Recv_init( gol_grid_cell(grid, row, col), count, type, hx->ranks[dir], opposite[dir] + 1, hx->comm, &hx->recv_request[b][dir]);
+		}
+	}
+}
+
+
+static void neighbour_init(halo_exchange* hx)
+{
+	int sources[HALO_NEIGHBOURS];
+	int destinations[HALO_NEIGHBOURS];
+	int weights[HALO_NEIGHBOURS]; //every edge weighs the same
+	int dir, row, col, count;
+	int n = 0;
+	MPI_Datatype type;
+	MPI_Aint base, address;
+
+	gol_grid grid = gol_array_grid(hx->arrays[0]);
+
+	MPI_Get_address(grid.cells, &base);
+
+	//A graph topology with our 8 neighbours (a cartesian communicator only knows the 4 non diagonal ones)
+	//The k-th edge we send to a process is matched with the k-th edge it receives from us,
+	//so the k-th source is the neighbour that has us on direction k: the one on the opposite side.
+	//Neighbours that are MPI_PROC_NULL are left out (every process leaves out the same directions)
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		if (hx->ranks[dir] == MPI_PROC_NULL)
+			continue;
+
+		edge_type(hx, dir, &count, &type);
+		hx->counts[n] = count;
+		hx->send_types[n] = type;
+		hx->recv_types[n] = type; //the opposite edge has the same type
+
+		destinations[n] = hx->ranks[dir];
+		send_position(hx->rows_per_block, hx->cols_per_block, dir, &row, &col);
+		MPI_Get_address(gol_grid_cell(grid, row, col), &address);
+		hx->send_displs[n] = address - base;
+
+		sources[n] = hx->ranks[opposite[dir]];
+		weights[n] = 1;
+		recv_position(hx->rows_per_block, hx->cols_per_block, opposite[dir], &row, &col);
+		MPI_Get_address(gol_grid_cell(grid, row, col), &address);
+		hx->recv_displs[n] = address - base;
+
+		n++;
+	}
+
+	hx->neighbours = n;
+	MPI_Dist_graph_create_adjacent(hx->comm, n, sources, weights, n, destinations, weights,
+		MPI_INFO_NULL, 0, &hx->graph_comm);
+
+#if MPI_VERSION >= 4
+	//persistent neighbourhood collectives, one for each buffer
+	int b;
+	for (b=0; b<2; b++)
+	{
+		gol_cell* buffer = hx->arrays[b]->flat_array;
+		MPI_Neighbor_alltoallw_init(buffer, hx->counts, hx->send_displs, hx->send_types,
+			buffer, hx->counts, hx->recv_displs, hx->recv_types, hx->graph_comm, MPI_INFO_NULL,
+			&hx->collective_request[b]);
+	}
+#else
+	hx->collective_request[0] = MPI_REQUEST_NULL;
+	hx->collective_request[1] = MPI_REQUEST_NULL;
+#endif
+}
+
+
+//Allocate both game arrays in a shared memory window of the processes on our node,
+//so that neighbours on the same node can read our edges directly
+void halo_exchange_alloc_shared(halo_exchange* hx, MPI_Comm comm, int lines, int columns,
+	gol_array** ga1, gol_array** ga2)
+{
+	MPI_Aint size = 2 * (MPI_Aint) lines * columns * sizeof(gol_cell);
+	MPI_Info info;
+	gol_cell* flat_array;
+
+	MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &hx->node_comm);
+
+	//every process gets its own (page aligned) segment, so its pages can stay local to it
+	MPI_Info_create(&info);
+	MPI_Info_set(info, "alloc_shared_noncontig", "true");
+	MPI_Win_allocate_shared(size, sizeof(gol_cell), info, hx->node_comm, &flat_array, &hx->win);
+	MPI_Info_free(&info);
+
+	memset(flat_array, 0, size);
+	*ga1 = gol_array_wrap(flat_array, lines, columns);
+	*ga2 = gol_array_wrap(flat_array + (size_t) lines*columns, lines, columns);
+}
+
+
+static void shm_init(halo_exchange* hx)
+{
+	int node_ranks[HALO_NEIGHBOURS];
+	int dir, disp_unit;
+	MPI_Aint size;
+	MPI_Group group, node_group;
+
+	//which of our neighbours are on our node
+	MPI_Comm_group(hx->comm, &group);
+	MPI_Comm_group(hx->node_comm, &node_group);
+	MPI_Group_translate_ranks(group, HALO_NEIGHBOURS, hx->ranks, node_group, node_ranks);
+	MPI_Group_free(&group);
+	MPI_Group_free(&node_group);
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		hx->shared[dir] = (node_ranks[dir] != MPI_UNDEFINED && node_ranks[dir] != MPI_PROC_NULL);
+		hx->neighbour_flat[dir] = NULL;
+
+		if (hx->shared[dir])
+			MPI_Win_shared_query(hx->win, node_ranks[dir], &size, &disp_unit, &hx->neighbour_flat[dir]);
+	}
+
+	//one passive epoch for the whole game, MPI_Win_sync makes the stores visible
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, hx->win);
+}
+
+
+//Copy the neighbour's edges into our halo straight from its block.
+//Its (empty) message means it has finished the previous generation, so its edges are final
+//and it is done reading ours. Inner cells are not touched by the neighbours, which is why they
+//can be computed before this.
+static void shm_load_halos(halo_exchange* hx, int communication_type)
+{
+	gol_grid grid = gol_array_grid(hx->arrays[communication_type]);
+	int dir, i, send_row, send_col, recv_row, recv_col;
+
+	MPI_Win_sync(hx->win);
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		if (!hx->shared[dir])
+			continue;
+
+		//the neighbour's block might not have our size (only the same rows, or cols, as ours)
+		int rows = hx->neighbour_rows[dir];
+		int cols = hx->neighbour_cols[dir];
+		gol_cell* neighbour = hx->neighbour_flat[dir] + (size_t) communication_type*(rows + 2)*(cols + 2);
+
+		//the neighbour on our up side sends its down edge etc
+		send_position(rows, cols, opposite[dir], &send_row, &send_col);
+		recv_position(hx->rows_per_block, hx->cols_per_block, dir, &recv_row, &recv_col);
+		gol_cell* edge = &neighbour[(size_t) send_row*(cols + 2) + send_col];
+
+		if (dir == HALO_UP || dir == HALO_DOWN)
+		{
+			memcpy(gol_grid_cell(grid, recv_row, recv_col), edge, hx->cols_per_block*sizeof(gol_cell));
+		}
+		else if (dir == HALO_LEFT || dir == HALO_RIGHT)
+		{
+			for (i=0; i<hx->rows_per_block; i++)
+				*gol_grid_cell(grid, recv_row + i, recv_col) = edge[(size_t) i*(cols + 2)];
+		}
+		else
+		{
+			*gol_grid_cell(grid, recv_row, recv_col) = *edge;
+		}
+	}
+}
+
+
+
+static void rma_init(halo_exchange* hx)
+{
+	int lines = hx->rows_per_block + 2;
+	int columns = hx->cols_per_block + 2;
+	int group_ranks[HALO_NEIGHBOURS];
+	int b, dir, i, row, col;
+	int n = 0;
+	MPI_Group group;
+	MPI_Info info;
+
+	//our edge for direction dir goes to the neighbour's halo on the opposite side (in the neighbour's layout)
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		recv_position(hx->neighbour_rows[dir], hx->neighbour_cols[dir], opposite[dir], &row, &col);
+		hx->target_disps[dir] = (MPI_Aint) row*(hx->neighbour_cols[dir] + 2) + col;
+
+		//a col of the neighbour's block has its own stride
+		if (dir == HALO_LEFT || dir == HALO_RIGHT)
+		{
+			MPI_Type_vector(hx->rows_per_block, 1, hx->neighbour_cols[dir] + 2, GOL_CELL_MPI, &hx->target_types[dir]);
+			MPI_Type_commit(&hx->target_types[dir]);
+		}
+		else
+		{
+			hx->target_types[dir] = GOL_CELL_MPI;
+		}
+	}
+
+	//the same process might be our neighbour on more than one side, but a group has distinct ranks
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		if (hx->ranks[dir] == MPI_PROC_NULL)
+			continue;
+
+		for (i=0; i<n; i++)
+		{
+			if (group_ranks[i] == hx->ranks[dir])
+				break;
+		}
+
+		if (i == n)
+			group_ranks[n++] = hx->ranks[dir];
+	}
+
+	MPI_Comm_group(hx->comm, &group);
+	MPI_Group_incl(group, n, group_ranks, &hx->neighbour_group);
+	MPI_Group_free(&group);
+
+	//only post/start/complete/wait epochs are used
+	MPI_Info_create(&info);
+	MPI_Info_set(info, "no_locks", "true");
+
+	for (b=0; b<2; b++)
+	{
+		MPI_Win_create(hx->arrays[b]->flat_array, (MPI_Aint) lines*columns*sizeof(gol_cell), sizeof(gol_cell),
+			info, hx->comm, &hx->rma_win[b]);
+	}
+
+	MPI_Info_free(&info);
+}
+
+
+static void rma_start(halo_exchange* hx, int communication_type)
+{
+	MPI_Win win = hx->rma_win[communication_type];
+	gol_grid grid = gol_array_grid(hx->arrays[communication_type]);
+	int dir, row, col, count;
+	MPI_Datatype type;
+
+	//expose our halos to the neighbours (no MPI_MODE_NOSTORE: the previous generation wrote this array)
+	MPI_Win_post(hx->neighbour_group, 0, win);
+
+	//and put our edges into theirs
+	MPI_Win_start(hx->neighbour_group, 0, win);
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		if (hx->ranks[dir] == MPI_PROC_NULL)
+			continue;
+
+		edge_type(hx, dir, &count, &type);
+
+		if (dir == HALO_LEFT || dir == HALO_RIGHT)
+		{
+			MPI_Put(hx->side_edges[communication_type][dir], hx->rows_per_block, GOL_CELL_MPI, hx->ranks[dir],
+				hx->target_disps[dir], count, hx->target_types[dir], win);
+			continue;
+		}
+
+		send_position(hx->rows_per_block, hx->cols_per_block, dir, &row, &col);
+		MPI_Put(gol_grid_cell(grid, row, col), count, type, hx->ranks[dir], hx->target_disps[dir], count, hx->target_types[dir], win);
+	}
+}
+
+
+static void rma_wait(halo_exchange* hx, int communication_type)
+{
+	MPI_Win win = hx->rma_win[communication_type];
+
+	//our puts are done
+	MPI_Win_complete(win);
+	//the neighbours' puts into our halos are done
+	MPI_Win_wait(win);
+}
+
+
+//cells of the edge sent to direction dir, copied to a contiguous edge
+static void pack_edge(halo_exchange* hx, int communication_type, int dir, gol_cell* edge)
+{
+	gol_grid grid = gol_array_grid(hx->arrays[communication_type]);
+	int row, col;
+
+	send_position(hx->rows_per_block, hx->cols_per_block, dir, &row, &col);
+
+	if (dir == HALO_LEFT || dir == HALO_RIGHT)
+	{
+		memcpy(edge, hx->side_edges[communication_type][dir], hx->rows_per_block*sizeof(gol_cell));
+	}
+	else
+	{
+		memcpy(edge, gol_grid_cell(grid, row, col), hx->edge_length[dir]*sizeof(gol_cell));
+	}
+}
+
+
+//a contiguous edge copied to the halo of direction dir
+static void unpack_halo(halo_exchange* hx, int communication_type, int dir, gol_cell* edge)
+{
+	gol_grid grid = gol_array_grid(hx->arrays[communication_type]);
+	int row, col;
+
+	recv_position(hx->rows_per_block, hx->cols_per_block, dir, &row, &col);
+
+	if (dir == HALO_LEFT || dir == HALO_RIGHT)
+	{
+		unpack_col(gol_grid_cell(grid, row, col), grid.stride, edge, hx->rows_per_block);
+	}
+	else
+	{
+		memcpy(gol_grid_cell(grid, row, col), edge, hx->edge_length[dir]*sizeof(gol_cell));
+	}
+}
+
+
+static void delta_init(halo_exchange* hx)
+{
+	int dir;
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		//a sparse message is only used while it is smaller than the whole edge (the last flip can overshoot it)
+		int size = DELTA_HEADER + hx->edge_length[dir]*sizeof(gol_cell);
+		hx->delta_send[dir] = malloc(size + sizeof(int));
+		hx->delta_recv[dir] = malloc(size);
+		hx->last_sent[dir] = calloc(hx->edge_length[dir], sizeof(gol_cell));
+		hx->last_received[dir] = calloc(hx->edge_length[dir], sizeof(gol_cell));
+
+		MPI_Recv_init(hx->delta_recv[dir], size, MPI_BYTE, hx->ranks[dir], opposite[dir] + 1, hx->comm,
+			&hx->recv_request[0][dir]);
+		hx->send_request[0][dir] = MPI_REQUEST_NULL;
+	}
+
+	hx->first_send = 1;
+}
+
+
+static void delta_start(halo_exchange* hx, int communication_type)
+{
+	gol_cell edge_cells[hx->rows_per_block > hx->cols_per_block ? hx->rows_per_block : hx->cols_per_block];
+	int dir, i;
+
+	MPI_Startall(HALO_NEIGHBOURS, hx->recv_request[0]);
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		if (hx->ranks[dir] == MPI_PROC_NULL)
+			continue;
+
+		int n = hx->edge_length[dir];
+		int* header = (int*) hx->delta_send[dir];
+		int* flips = header + 2;
+		int k = 0;
+		int size;
+
+		pack_edge(hx, communication_type, dir, edge_cells);
+
+		//which cells flipped since the last message (stop once the whole edge is smaller)
+		for (i=0; i<n && k*sizeof(int) < n*sizeof(gol_cell); i++)
+		{
+			if (edge_cells[i] != hx->last_sent[dir][i])
+				flips[k++] = i;
+		}
+
+		if (hx->first_send || k*sizeof(int) >= n*sizeof(gol_cell))
+		{
+			header[0] = DELTA_FULL;
+			memcpy(flips, edge_cells, n*sizeof(gol_cell));
+			size = DELTA_HEADER + n*sizeof(gol_cell);
+		}
+		else if (k == 0)
+		{
+			header[0] = DELTA_UNCHANGED;
+			size = DELTA_HEADER;
+		}
+		else
+		{
+			header[0] = DELTA_SPARSE;
+			size = DELTA_HEADER + k*sizeof(int);
+		}
+
+		header[1] = k;
+		memcpy(hx->last_sent[dir], edge_cells, n*sizeof(gol_cell));
+		MPI_Isend(hx->delta_send[dir], size, MPI_BYTE, hx->ranks[dir], dir + 1, hx->comm, &hx->send_request[0][dir]);
+	}
+
+	hx->first_send = 0;
+}
+
+
+static void delta_wait(halo_exchange* hx, int communication_type)
+{
+	int dir, i;
+
+	MPI_Waitall(HALO_NEIGHBOURS, hx->recv_request[0], MPI_STATUSES_IGNORE);
+	hx->halos_changed = 0;
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		if (hx->ranks[dir] == MPI_PROC_NULL)
+			continue;
+
+		int* header = (int*) hx->delta_recv[dir];
+		gol_cell* halo = hx->last_received[dir];
+
+		if (header[0] == DELTA_FULL)
+		{
+			memcpy(halo, header + 2, hx->edge_length[dir]*sizeof(gol_cell));
+		}
+		else if (header[0] == DELTA_SPARSE)
+		{
+			for (i=0; i<header[1]; i++)
+				halo[header[2 + i]] = !halo[header[2 + i]];
+		}
+
+		if (header[0] != DELTA_UNCHANGED)
+			hx->halos_changed = 1;
+
+		//the other array has the previous halo, this one the one before, so the halo is always copied
+		unpack_halo(hx, communication_type, dir, halo);
+	}
+}
+
+
+//tag of the message of generation 'generation' towards direction dir
+//(generations that are in flight at the same time never share a tag)
+static int async_tag(halo_exchange* hx, int generation, int dir)
+{
+	return (generation % (hx->max_skew + 1)) * HALO_NEIGHBOURS + dir + 1;
+}
+
+
+static void async_post_recvs(halo_exchange* hx, int generation)
+{
+	int slot = generation % (hx->max_skew + 1);
+	int dir;
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		MPI_Irecv(hx->async_recv[slot][dir], hx->edge_length[dir], GOL_CELL_MPI, hx->ranks[dir],
+			async_tag(hx, generation, opposite[dir]), hx->async_comm, &hx->async_recv_request[slot][dir]);
+	}
+}
+
+
+static void async_init(halo_exchange* hx)
+{
+	int slots = hx->max_skew + 1;
+	int slot, dir;
+
+	hx->async_send = malloc(slots*sizeof(gol_cell**));
+	hx->async_recv = malloc(slots*sizeof(gol_cell**));
+	hx->async_send_request = malloc(slots*sizeof(MPI_Request*));
+	hx->async_recv_request = malloc(slots*sizeof(MPI_Request*));
+
+	for (slot=0; slot<slots; slot++)
+	{
+		hx->async_send[slot] = malloc(HALO_NEIGHBOURS*sizeof(gol_cell*));
+		hx->async_recv[slot] = malloc(HALO_NEIGHBOURS*sizeof(gol_cell*));
+		hx->async_send_request[slot] = malloc(HALO_NEIGHBOURS*sizeof(MPI_Request));
+		hx->async_recv_request[slot] = malloc(HALO_NEIGHBOURS*sizeof(MPI_Request));
+
+		for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+		{
+			hx->async_send[slot][dir] = malloc(hx->edge_length[dir]*sizeof(gol_cell));
+			hx->async_recv[slot][dir] = malloc(hx->edge_length[dir]*sizeof(gol_cell));
+			hx->async_send_request[slot][dir] = MPI_REQUEST_NULL;
+		}
+	}
+
+	//our own communicator, so that halos sent ahead of time never meet the messages of
+	//an older halo_exchange that is still being freed (after repartitioning)
+	MPI_Comm_dup(hx->comm, &hx->async_comm);
+
+	//the halos of the next max_skew + 1 generations can arrive before we get to them
+	hx->generation = 0;
+	for (slot=0; slot<slots; slot++)
+		async_post_recvs(hx, slot);
+}
+
+
+static void async_start(halo_exchange* hx, int communication_type)
+{
+	int slot = hx->generation % (hx->max_skew + 1);
+	int dir;
+
+	//the edges sent max_skew + 1 generations ago must have left their buffers
+	//(this is what bounds how far we run ahead of a slow neighbour)
+	MPI_Waitall(HALO_NEIGHBOURS, hx->async_send_request[slot], MPI_STATUSES_IGNORE);
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		if (hx->ranks[dir] == MPI_PROC_NULL)
+			continue;
+
+		pack_edge(hx, communication_type, dir, hx->async_send[slot][dir]);
+		MPI_Isend(hx->async_send[slot][dir], hx->edge_length[dir], GOL_CELL_MPI, hx->ranks[dir],
+			async_tag(hx, hx->generation, dir), hx->async_comm, &hx->async_send_request[slot][dir]);
+	}
+}
+
+
+static void async_wait(halo_exchange* hx, int communication_type)
+{
+	int slot = hx->generation % (hx->max_skew + 1);
+	int dir;
+
+	MPI_Waitall(HALO_NEIGHBOURS, hx->async_recv_request[slot], MPI_STATUSES_IGNORE);
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		if (hx->ranks[dir] != MPI_PROC_NULL)
+			unpack_halo(hx, communication_type, dir, hx->async_recv[slot][dir]);
+	}
+
+	//this slot now waits for the halos of a later generation
+	async_post_recvs(hx, hx->generation + hx->max_skew + 1);
+	hx->generation++;
+}
+
+
+static void async_free(halo_exchange* hx)
+{
+	int slots = hx->max_skew + 1;
+	int slot, dir;
+
+	for (slot=0; slot<slots; slot++)
+	{
+		//every process stops at the same generation, so our sends have all been received
+		//and the receives of the generations after it will never be matched
+		MPI_Waitall(HALO_NEIGHBOURS, hx->async_send_request[slot], MPI_STATUSES_IGNORE);
+
+		for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+		{
+			if (hx->async_recv_request[slot][dir] != MPI_REQUEST_NULL)
+				MPI_Cancel(&hx->async_recv_request[slot][dir]);
+		}
+		MPI_Waitall(HALO_NEIGHBOURS, hx->async_recv_request[slot], MPI_STATUSES_IGNORE);
+
+		for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+		{
+			free(hx->async_send[slot][dir]);
+			free(hx->async_recv[slot][dir]);
+		}
+		free(hx->async_send[slot]);
+		free(hx->async_recv[slot]);
+		free(hx->async_send_request[slot]);
+		free(hx->async_recv_request[slot]);
+	}
+
+	free(hx->async_send);
+	free(hx->async_recv);
+	free(hx->async_send_request);
+	free(hx->async_recv_request);
+	MPI_Comm_free(&hx->async_comm);
+}
+
+
+//Poll the requests of the exchange in flight, so that MPI moves them forward
+//(many implementations only move a large message when they are called)
+//Completed requests become inactive, so the waits that follow return at once
+void halo_exchange_progress(halo_exchange* hx, int communication_type)
+{
+	int flag;
+
+	if (hx->type == HALO_EXCHANGE_NEIGHBOUR)
+	{
+		MPI_Test(&hx->collective_request[communication_type], &flag, MPI_STATUS_IGNORE);
+	}
+	else if (hx->type == HALO_EXCHANGE_RMA)
+	{
+		//testing the epoch would end it, any call into MPI will do
+		MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, hx->comm, &flag, MPI_STATUS_IGNORE);
+	}
+	else if (hx->type == HALO_EXCHANGE_DELTA)
+	{
+		MPI_Testall(HALO_NEIGHBOURS, hx->recv_request[0], &flag, MPI_STATUSES_IGNORE);
+		MPI_Testall(HALO_NEIGHBOURS, hx->send_request[0], &flag, MPI_STATUSES_IGNORE);
+	}
+	else if (hx->type == HALO_EXCHANGE_ASYNC)
+	{
+		int slot = hx->generation % (hx->max_skew + 1);
+
+		MPI_Testall(HALO_NEIGHBOURS, hx->async_recv_request[slot], &flag, MPI_STATUSES_IGNORE);
+		MPI_Testall(HALO_NEIGHBOURS, hx->async_send_request[slot], &flag, MPI_STATUSES_IGNORE);
+	}
+	else
+	{
+		MPI_Testall(HALO_NEIGHBOURS, hx->recv_request[communication_type], &flag, MPI_STATUSES_IGNORE);
+		MPI_Testall(HALO_NEIGHBOURS, hx->send_request[communication_type], &flag, MPI_STATUSES_IGNORE);
+	}
+}
+
+
+//Progress thread: polls the exchange between halo_exchange_start and halo_exchange_wait_recvs.
+//The main thread never touches the requests in that window, and it takes the lock before
+//it does again, so the two never work on the same request at once.
+static void* progress_thread(void* arg)
+{
+	halo_exchange* hx = arg;
+	struct timespec interval = { 0, HALO_PROGRESS_INTERVAL_US*1000 };
+
+	while (1)
+	{
+		pthread_mutex_lock(&hx->progress_lock);
+
+		if (hx->progress_quit)
+		{
+			pthread_mutex_unlock(&hx->progress_lock);
+			break;
+		}
+
+		if (hx->progress_active)
+			halo_exchange_progress(hx, hx->progress_type);
+
+		pthread_mutex_unlock(&hx->progress_lock);
+		nanosleep(&interval, NULL);
+	}
+
+	return NULL;
+}
+
+
+static void progress_hand_over(halo_exchange* hx, int active, int communication_type)
+{
+	pthread_mutex_lock(&hx->progress_lock);
+	hx->progress_active = active;
+	hx->progress_type = communication_type;
+	pthread_mutex_unlock(&hx->progress_lock);
+}
+
+
+void halo_exchange_init(halo_exchange* hx, int type, MPI_Comm comm, int* ranks,
+	int rows_per_block, int cols_per_block, gol_array* ga1, gol_array* ga2, int max_skew, int progress)
+{
+	int b, dir, count;
+	MPI_Datatype edge;
+
+	hx->type = type;
+	hx->comm = comm;
+	memcpy(hx->ranks, ranks, HALO_NEIGHBOURS*sizeof(int));
+	hx->rows_per_block = rows_per_block;
+	hx->cols_per_block = cols_per_block;
+	hx->arrays[0] = ga1;
+	hx->arrays[1] = ga2;
+	hx->graph_comm = MPI_COMM_NULL;
+	hx->halos_changed = 1;
+	hx->max_skew = max_skew;
+	hx->progress = progress;
+
+	//Define our column derived data type
+	MPI_Type_vector(rows_per_block,
+	   1,
+	   gol_array_grid(ga1).stride,
+	   GOL_CELL_MPI,
+	   &hx->col_type);
+
+	MPI_Type_commit(&hx->col_type);
+
+	for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+	{
+		edge_type(hx, dir, &count, &edge);
+		hx->edge_length[dir] = (edge == hx->col_type) ? hx->rows_per_block : count;
+	}
+
+	exchange_block_sizes(hx);
+
+	//our left/right edges are kept in contiguous buffers by the compute kernels
+	//(they start as a copy of the arrays, which were filled before we got them)
+	for (b=0; b<2; b++)
+	{
+		for (dir=HALO_LEFT; dir<=HALO_RIGHT; dir++)
+		{
+			hx->side_edges[b][dir] = malloc(rows_per_block*sizeof(gol_cell));
+			hx->side_halos[b][dir] = malloc(rows_per_block*sizeof(gol_cell));
+		}
+		halo_exchange_pack_sides(hx, b);
+	}
+
+	if (type == HALO_EXCHANGE_NEIGHBOUR)
+	{
+		neighbour_init(hx);
+	}
+	else if (type == HALO_EXCHANGE_RMA)
+	{
+		rma_init(hx);
+	}
+	else if (type == HALO_EXCHANGE_DELTA)
+	{
+		delta_init(hx);
+	}
+	else if (type == HALO_EXCHANGE_ASYNC)
+	{
+		async_init(hx);
+	}
+	else
+	{
+		if (type == HALO_EXCHANGE_SHM)
+			shm_init(hx);
+		p2p_init(hx);
+	}
+
+	if (progress == HALO_PROGRESS_THREAD)
+	{
+		hx->progress_active = 0;
+		hx->progress_quit = 0;
+		pthread_mutex_init(&hx->progress_lock, NULL);
+		pthread_create(&hx->progress_thread, NULL, progress_thread, hx);
+	}
+}
+
+
+void halo_exchange_start(halo_exchange* hx, int communication_type)
+{
+	if (hx->type == HALO_EXCHANGE_NEIGHBOUR)
+	{
+#if MPI_VERSION >= 4
+		MPI_Start(&hx->collective_request[communication_type]);
+#else
+		gol_cell* buffer = hx->arrays[communication_type]->flat_array;
+		MPI_Ineighbor_alltoallw(buffer, hx->counts, hx->send_displs, hx->send_types,
+			buffer, hx->counts, hx->recv_displs, hx->recv_types, hx->graph_comm,
+			&hx->collective_request[communication_type]);
+#endif
+	}
+	else if (hx->type == HALO_EXCHANGE_RMA)
+	{
+		rma_start(hx, communication_type);
+	}
+	else if (hx->type == HALO_EXCHANGE_DELTA)
+	{
+		delta_start(hx, communication_type);
+	}
+	else if (hx->type == HALO_EXCHANGE_ASYNC)
+	{
+		async_start(hx, communication_type);
+	}
+	else
+	{
+		//our block must be visible to the neighbours of our node before we tell them it is ready
+		if (hx->type == HALO_EXCHANGE_SHM)
+			MPI_Win_sync(hx->win);
+
+		//8 Isend
+		MPI_Startall(HALO_NEIGHBOURS, hx->send_request[communication_type]);
+		//8 IRecv
+		MPI_Startall(HALO_NEIGHBOURS, hx->recv_request[communication_type]);
+	}
+
+	if (hx->progress == HALO_PROGRESS_THREAD)
+		progress_hand_over(hx, 1, communication_type);
+}
+
+
+void halo_exchange_wait_recvs(halo_exchange* hx, int communication_type)
+{
+	if (hx->progress == HALO_PROGRESS_THREAD)
+		progress_hand_over(hx, 0, communication_type);
+
+	if (hx->type == HALO_EXCHANGE_NEIGHBOUR)
+		MPI_Wait(&hx->collective_request[communication_type], MPI_STATUS_IGNORE);
+	else if (hx->type == HALO_EXCHANGE_RMA)
+		rma_wait(hx, communication_type);
+	else if (hx->type == HALO_EXCHANGE_DELTA)
+		delta_wait(hx, communication_type);
+	else if (hx->type == HALO_EXCHANGE_ASYNC)
+		async_wait(hx, communication_type);
+	else
+	{
+		MPI_Waitall(HALO_NEIGHBOURS, hx->recv_request[communication_type], MPI_STATUSES_IGNORE);
+		unpack_side_halos(hx, communication_type);
+	}
+
+	if (hx->type == HALO_EXCHANGE_SHM)
+		shm_load_halos(hx, communication_type);
+}
+
+
+void halo_exchange_wait_sends(halo_exchange* hx, int communication_type)
+{
+	//the collective (or the RMA epoch) has already completed its sends along with its receives
+	//(and the async sends are only waited for when their buffers are needed again)
+	if (hx->type == HALO_EXCHANGE_P2P || hx->type == HALO_EXCHANGE_SHM)
+		MPI_Waitall(HALO_NEIGHBOURS, hx->send_request[communication_type], MPI_STATUSES_IGNORE);
+	else if (hx->type == HALO_EXCHANGE_DELTA)
+		MPI_Waitall(HALO_NEIGHBOURS, hx->send_request[0], MPI_STATUSES_IGNORE);
+}
+
+
+void halo_exchange_free(halo_exchange* hx)
+{
+	int b, dir;
+
+	if (hx->progress == HALO_PROGRESS_THREAD)
+	{
+		pthread_mutex_lock(&hx->progress_lock);
+		hx->progress_quit = 1;
+		pthread_mutex_unlock(&hx->progress_lock);
+		pthread_join(hx->progress_thread, NULL);
+		pthread_mutex_destroy(&hx->progress_lock);
+	}
+
+	if (hx->type == HALO_EXCHANGE_NEIGHBOUR)
+	{
+#if MPI_VERSION >= 4
+		for (b=0; b<2; b++)
+			MPI_Request_free(&hx->collective_request[b]);
+#endif
+		MPI_Comm_free(&hx->graph_comm);
+	}
+	else if (hx->type == HALO_EXCHANGE_RMA)
+	{
+		for (b=0; b<2; b++)
+			MPI_Win_free(&hx->rma_win[b]);
+		MPI_Group_free(&hx->neighbour_group);
+		MPI_Type_free(&hx->target_types[HALO_LEFT]);
+		MPI_Type_free(&hx->target_types[HALO_RIGHT]);
+	}
+	else if (hx->type == HALO_EXCHANGE_DELTA)
+	{
+		for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+		{
+			//a send that was not waited for (we terminated) completes on its own
+			if (hx->send_request[0][dir] != MPI_REQUEST_NULL)
+				MPI_Request_free(&hx->send_request[0][dir]);
+			MPI_Request_free(&hx->recv_request[0][dir]);
+			free(hx->delta_send[dir]);
+			free(hx->delta_recv[dir]);
+			free(hx->last_sent[dir]);
+			free(hx->last_received[dir]);
+		}
+	}
+	else if (hx->type == HALO_EXCHANGE_ASYNC)
+	{
+		async_free(hx);
+	}
+	else
+	{
+		for (b=0; b<2; b++)
+		{
+			for (dir=0; dir<HALO_NEIGHBOURS; dir++)
+			{
+				MPI_Request_free(&hx->send_request[b][dir]);
+				MPI_Request_free(&hx->recv_request[b][dir]);
+			}
+		}
+	}
+
+	if (hx->type == HALO_EXCHANGE_SHM)
+	{
+		//the game arrays live in the window, free them (gol_array_free) only after this
+		MPI_Win_unlock_all(hx->win);
+		MPI_Win_free(&hx->win);
+		MPI_Comm_free(&hx->node_comm);
+	}
+
+	for (b=0; b<2; b++)
+	{
+		for (dir=HALO_LEFT; dir<=HALO_RIGHT; dir++)
+		{
+			free(hx->side_edges[b][dir]);
+			free(hx->side_halos[b][dir]);
+		}
+	}
+
+	MPI_Type_free(&hx->col_type);
+}
+
+
+//copy the left/right edges of an array to their buffers
+//(for arrays that were not written by a kernel that keeps them up to date)
+void halo_exchange_pack_sides(halo_exchange* hx, int communication_type)
+{
+	gol_grid grid = gol_array_grid(hx->arrays[communication_type]);
+	int dir, row, col;
+
+	for (dir=HALO_LEFT; dir<=HALO_RIGHT; dir++)
+	{
+		send_position(hx->rows_per_block, hx->cols_per_block, dir, &row, &col);
+		pack_col(hx->side_edges[communication_type][dir], gol_grid_cell(grid, row, col), grid.stride, hx->rows_per_block);
+	}
+}
@@ -0,0 +1,123 @@
+#ifndef HALO_EXCHANGE_H
+#define HALO_EXCHANGE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <mpi.h>
+#include "gol_array.h"
+
+//the 8 neighbours of a block, in the order used for tags and requests
+#define HALO_UP 0
+#define HALO_DOWN 1
+#define HALO_LEFT 2
+#define HALO_RIGHT 3
+#define HALO_UP_LEFT 4
+#define HALO_UP_RIGHT 5
+#define HALO_DOWN_LEFT 6
+#define HALO_DOWN_RIGHT 7
+#define HALO_NEIGHBOURS 8
+
+//available halo exchange backends (selected at runtime)
+#define HALO_EXCHANGE_P2P 0 //16 persistent point to point requests per buffer
+#define HALO_EXCHANGE_NEIGHBOUR 1 //one neighbourhood collective (MPI_Neighbor_alltoallw) per generation
+#define HALO_EXCHANGE_SHM 2 //p2p, but halos of neighbours on the same node are loaded from their shared memory blocks
+#define HALO_EXCHANGE_RMA 3 //edges are MPI_Put into the neighbours' halos, post/start/complete/wait epochs
+#define HALO_EXCHANGE_DELTA 4 //p2p, but an edge is sent as 'unchanged', as the cells that flipped, or whole
+#define HALO_EXCHANGE_ASYNC 5 //p2p tagged with the generation, so that we can run up to max_skew generations ahead
+
+//how the exchange is moved forward while we compute (selected at runtime)
+#define HALO_PROGRESS_NONE 0 //only by the waits
+#define HALO_PROGRESS_TEST 1 //by the compute loops calling halo_exchange_progress every few rows
+#define HALO_PROGRESS_THREAD 2 //by a thread that polls it (needs MPI_THREAD_MULTIPLE)
+#define HALO_PROGRESS_INTERVAL_US 20 //how often the progress thread polls
+
+struct halo_exchange
+{
+	int type;
+	MPI_Comm comm;
+	int ranks[HALO_NEIGHBOURS]; //neighbour ranks, MPI_PROC_NULL if there is no need to communicate
+	int rows_per_block;
+	int cols_per_block;
+	int neighbour_rows[HALO_NEIGHBOURS]; //size of the neighbours' blocks
+	int neighbour_cols[HALO_NEIGHBOURS];
+	gol_array* arrays[2]; //the two (swapped) game arrays, index is the 'communication type'
+	MPI_Datatype col_type;
+	int halos_changed; //0 if no halo changed since the previous generation (only known by HALO_EXCHANGE_DELTA)
+	int edge_length[HALO_NEIGHBOURS]; //cells of each edge
+	int max_skew; //generations whose halos can be in flight at the same time (HALO_EXCHANGE_ASYNC)
+
+	//our left/right edges of each array, written by the compute kernels along with the array,
+	//and the left/right halos as they arrive (only [HALO_LEFT] and [HALO_RIGHT] are used)
+	gol_cell* side_edges[2][HALO_NEIGHBOURS];
+	gol_cell* side_halos[2][HALO_NEIGHBOURS];
+
+	int progress;
+	pthread_t progress_thread;
+	pthread_mutex_t progress_lock;
+	int progress_active; //an exchange is in flight and the main thread is not waiting for it
+	int progress_type; //its communication type
+	int progress_quit;
+
+	//HALO_EXCHANGE_P2P
+	MPI_Request send_request[2][HALO_NEIGHBOURS];
+	MPI_Request recv_request[2][HALO_NEIGHBOURS];
+
+	//HALO_EXCHANGE_NEIGHBOUR
+	MPI_Comm graph_comm;
+	int neighbours; //edges of graph_comm (neighbours that are not MPI_PROC_NULL)
+	int counts[HALO_NEIGHBOURS];
+	MPI_Aint send_displs[HALO_NEIGHBOURS];
+	MPI_Aint recv_displs[HALO_NEIGHBOURS];
+	MPI_Datatype send_types[HALO_NEIGHBOURS];
+	MPI_Datatype recv_types[HALO_NEIGHBOURS];
+	MPI_Request collective_request[2];
+
+	//HALO_EXCHANGE_SHM
+	MPI_Comm node_comm; //processes that share memory with us
+	MPI_Win win; //both game arrays of every process of node_comm
+	int shared[HALO_NEIGHBOURS]; //1 if the neighbour is on our node
+	gol_cell* neighbour_flat[HALO_NEIGHBOURS]; //the neighbour's first game array (the second one follows it)
+
+	//HALO_EXCHANGE_RMA
+	MPI_Win rma_win[2]; //one window for each game array
+	MPI_Group neighbour_group; //the (distinct) neighbours, both the origins and the targets of our epochs
+	MPI_Aint target_disps[HALO_NEIGHBOURS]; //where our edge goes in the neighbour's array
+	MPI_Datatype target_types[HALO_NEIGHBOURS];
+
+	//HALO_EXCHANGE_DELTA
+	char* delta_send[HALO_NEIGHBOURS]; //encoded messages
+	char* delta_recv[HALO_NEIGHBOURS];
+	gol_cell* last_sent[HALO_NEIGHBOURS]; //the edges the messages are relative to
+	gol_cell* last_received[HALO_NEIGHBOURS];
+	int first_send; //nothing has been sent yet, so every edge goes whole
+
+	//HALO_EXCHANGE_ASYNC
+	MPI_Comm async_comm;
+	int generation; //the generation whose halos we exchange next
+	gol_cell*** async_send; //[generation % (max_skew + 1)][direction] edge buffers
+	gol_cell*** async_recv;
+	MPI_Request** async_send_request;
+	MPI_Request** async_recv_request;
+};
+
+typedef struct halo_exchange halo_exchange;
+
+int halo_exchange_type_from_str(char* str);
+const char* halo_exchange_type_str(int type);
+int halo_progress_from_str(char* str);
+const char* halo_progress_str(int progress);
+void halo_exchange_alloc_shared(halo_exchange* hx, MPI_Comm comm, int lines, int columns,
+	gol_array** ga1, gol_array** ga2);
+void halo_exchange_init(halo_exchange* hx, int type, MPI_Comm comm, int* ranks,
+	int rows_per_block, int cols_per_block, gol_array* ga1, gol_array* ga2, int max_skew, int progress);
+void halo_exchange_start(halo_exchange* hx, int communication_type);
+void halo_exchange_progress(halo_exchange* hx, int communication_type);
+void halo_exchange_wait_recvs(halo_exchange* hx, int communication_type);
+void halo_exchange_wait_sends(halo_exchange* hx, int communication_type);
+void halo_exchange_free(halo_exchange* hx);
+void halo_exchange_pack_sides(halo_exchange* hx, int communication_type);
+
+#endif
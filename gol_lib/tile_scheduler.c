@@ -0,0 +1,109 @@
+#include "tile_scheduler.h"
+
+//A generation goes like this:
+//every thread resets its deque and pushes (a subset of) the tiles of its band,
+//a barrier, then every thread calls tile_scheduler_next until it returns -1.
+//Nothing is pushed while tiles are being taken, so once every deque was seen empty we are done
+
+
+tile_scheduler* tile_scheduler_init(int threads, int tiles)
+{
+	tile_scheduler* ts = malloc(sizeof(tile_scheduler));
+	assert(ts != NULL);
+	int i;
+
+	ts->threads = threads;
+	ts->tiles = tiles;
+
+	int ret = posix_memalign((void**) &ts->deques, TILE_SCHEDULER_CACHE_LINE, threads * sizeof(tile_deque));
+	assert(ret == 0);
+
+	for (i=0; i<threads; i++)
+	{
+		//a deque never holds more than its band, but a band can be as big as all the tiles
+		ts->deques[i].tiles = malloc((tiles + 1) * sizeof(int));
+		assert(ts->deques[i].tiles != NULL);
+		ts->deques[i].head = 0;
+		ts->deques[i].tail = 0;
+		omp_init_lock(&ts->deques[i].lock);
+	}
+
+	return ts;
+}
+
+
+
+void tile_scheduler_free(tile_scheduler** ts)
+{
+	tile_scheduler* ts_ptr = *ts;
+	int i;
+
+	for (i=0; i<ts_ptr->threads; i++)
+	{
+		omp_destroy_lock(&ts_ptr->deques[i].lock);
+		free(ts_ptr->deques[i].tiles);
+	}
+
+	free(ts_ptr->deques);
+	free(ts_ptr);
+	*ts = NULL;
+}
+
+
+
+int tile_scheduler_band_start(tile_scheduler* ts, int thread)
+{
+	//the first tile of a thread's band of consecutive tiles (the next thread's band starts where it ends)
+	return (int) ((long) thread * ts->tiles / ts->threads);
+}
+
+
+
+void tile_scheduler_reset(tile_scheduler* ts, int thread)
+{
+	tile_deque* deque = &ts->deques[thread];
+
+	omp_set_lock(&deque->lock);
+	deque->head = 0;
+	deque->tail = 0;
+	omp_unset_lock(&deque->lock);
+}
+
+
+
+void tile_scheduler_push(tile_scheduler* ts, int thread, int tile)
+{
+	tile_deque* deque = &ts->deques[thread];
+
+	omp_set_lock(&deque->lock);
+	deque->tiles[deque->tail++] = tile;
+	omp_unset_lock(&deque->lock);
+}
+
+
+
+int tile_scheduler_next(tile_scheduler* ts, int thread)
+{
+	//our own tiles first, last pushed first (it is the closest to the one we just did)
+	//then steal the first tile of the other threads, starting with our neighbour
+	tile_deque* deque = &ts->deques[thread];
+	int tile = -1;
+	int i;
+
+	omp_set_lock(&deque->lock);
+	if (deque->tail > deque->head)
+		tile = deque->tiles[--deque->tail];
+	omp_unset_lock(&deque->lock);
+
+	for (i=1; tile == -1 && i<ts->threads; i++)
+	{
+		deque = &ts->deques[(thread + i) % ts->threads];
+
+		omp_set_lock(&deque->lock);
+		if (deque->tail > deque->head)
+			tile = deque->tiles[deque->head++];
+		omp_unset_lock(&deque->lock);
+	}
+
+	return tile;
+}
@@ -0,0 +1,38 @@
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <omp.h>
+
+#define TILE_SCHEDULER_CACHE_LINE 64
+
+//the tiles a thread was given, the owner takes them from the tail and thieves from the head
+struct tile_deque
+{
+	int* tiles;
+	int head;
+	int tail;
+	omp_lock_t lock;
+} __attribute__((aligned(TILE_SCHEDULER_CACHE_LINE)));
+
+typedef struct tile_deque tile_deque;
+
+struct tile_scheduler
+{
+	int threads;
+	int tiles;
+	tile_deque* deques; //one per thread, each in its own cache lines
+};
+
+typedef struct tile_scheduler tile_scheduler;
+
+tile_scheduler* tile_scheduler_init(int threads, int tiles);
+void tile_scheduler_free(tile_scheduler** ts);
+int tile_scheduler_band_start(tile_scheduler* ts, int thread);
+void tile_scheduler_reset(tile_scheduler* ts, int thread);
+void tile_scheduler_push(tile_scheduler* ts, int thread, int tile);
+int tile_scheduler_next(tile_scheduler* ts, int thread);
+
+#endif
@@ -3,12 +3,14 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <time.h>
 #include <sys/stat.h>
 
 #include <mpi.h>
 
 #include "./gol_lib/gol_array.h"
 #include "./gol_lib/functions.h"
+#include "./gol_lib/halo_exchange.h"
 
 #define DEBUG 0
 #define INFO 1
@@ -22,13 +24,35 @@
 #define MAX_LOOPS 200
 #define REDUCE_RATE 1
 #define SAVE_GENERATED 0
+#define EXCHANGE_TYPE HALO_EXCHANGE_P2P
+#define REPARTITION_RATE 0 //0 for static blocks
+#define REPARTITION_ACTIVITY 8 //cost of a changed cell, compared to the cost of computing a cell
+#define REPARTITION_TOLERANCE 1.05 //repartition only if the most loaded part gets this much lighter
+#define MAX_SKEW 1 //generations a process can run ahead of the termination check (and of its neighbours, with async halos)
+#define PROGRESS HALO_PROGRESS_NONE
+#define PROGRESS_ROWS 16 //rows of inner cells between two halo_exchange_progress calls (HALO_PROGRESS_TEST)
+#define NODE_MAPPING 1 //give the processes of each node a compact rectangle of blocks
+#define RANKS_PER_NODE 0 //0 to find the nodes with MPI_Comm_split_type, else pretend that nodes have this many processes
+#define ENSEMBLE_GROUP_SIZE 4 //processes that play each game of an ensemble (-E)
 
 void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int processors, int lines, int columns,
-										int rows_per_block, int cols_per_block, int blocks_per_row, MPI_Comm virtual_comm);
-void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines, int columns,
-										int rows_per_block, int cols_per_block, int blocks_per_row, MPI_Comm virtual_comm);
-void gol_array_gather(short int** array, short int** myarray, int my_rank, int processes, int row_start, int col_start, 
-	int blocks_per_row, int blocks_per_col, int rows_per_block, int cols_per_block, MPI_Datatype block_array, MPI_Comm virtual_comm);
+										int* row_cuts, int* col_cuts, int blocks_per_row, int blocks_per_col, MPI_Comm virtual_comm);
+void gol_array_generate_and_scatter(gol_array* gol_ar, unsigned int seed, int processors, int lines, int columns,
+										int* row_cuts, int* col_cuts, int blocks_per_row, int blocks_per_col, MPI_Comm virtual_comm);
+void gol_array_gather(gol_cell** array, gol_cell** myarray, int my_rank, int blocks_per_row, int blocks_per_col,
+	int* row_cuts, int* col_cuts, MPI_Comm virtual_comm);
+void activity_weights(long* weights, int n, int* changed, int offset, int local_n, long base, MPI_Comm virtual_comm);
+int balance_cuts(long* weights, int parts, int* cuts, int* new_cuts);
+void gol_array_migrate(gol_array* old_ga, gol_array* new_ga, int* my_coords, int blocks_per_row, int blocks_per_col,
+	int* old_row_cuts, int* old_col_cuts, int* new_row_cuts, int* new_col_cuts, MPI_Comm virtual_comm);
+int node_block_index(MPI_Comm game_comm, int blocks_per_row, int blocks_per_col, int* tile_rows, int* tile_cols);
+int block_of(int x, int* cuts, int blocks);
+void play_game(MPI_Comm game_comm, int cases, char** filenames, unsigned int* seeds, int N, int M, int max_loops, int reduce_rate,
+	int exchange_type, int repartition_rate, int max_skew, int progress, int* stopped_at, double* elapsed_times);
+void play_ensemble(char* jobs_file, int group_size, int max_loops, int reduce_rate,
+	int exchange_type, int repartition_rate, int max_skew, int progress);
+void play_batch(char* manifest, int N, int M, int max_loops, int reduce_rate,
+	int exchange_type, int repartition_rate, int max_skew, int progress);
 
 int main(int argc, char* argv[])
 {
@@ -36,10 +60,16 @@ int main(int argc, char* argv[])
 	int N,M;
 	int max_loops = -1;
 	int reduce_rate = -999;
+	int exchange_type = EXCHANGE_TYPE;
+	int repartition_rate = -1;
+	int max_skew = -1;
+	int progress = PROGRESS;
+	int thread_support;
+	char* jobs_file = NULL;
+	int group_size = ENSEMBLE_GROUP_SIZE;
+	char* manifest = NULL;
 
-	gol_array* ga1;
-	gol_array* ga2;
-	int i, j;
+	int i;
 
 	/* SECTION A
 		MPI Initialize
@@ -49,12 +79,19 @@ int main(int argc, char* argv[])
 
 	//MPI init
 	int my_rank, processors;
-	int tag = 201049;
-	MPI_Status status;
-	int coordinates[2];
 	char* filename = NULL;
 
-	MPI_Init (&argc, &argv);
+	//the progress thread needs MPI_THREAD_MULTIPLE, which can only be asked for now
+	for (i=1; i<argc-1; i++)
+	{
+		if ( !strcmp(argv[i], "-g") )
+			progress = halo_progress_from_str(argv[i+1]);
+	}
+
+	if (progress == HALO_PROGRESS_THREAD)
+		MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+	else
+		MPI_Init (&argc, &argv);
 	MPI_Comm_size(MPI_COMM_WORLD, &processors);
 	MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
 
@@ -91,6 +128,55 @@ int main(int argc, char* argv[])
 			reduce_rate = atoi(argv[i+1]);
 			i++;
 		}
+		else if ( !strcmp(argv[i], "-p") )
+		{
+			repartition_rate = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-s") )
+		{
+			max_skew = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-E") )
+		{
+			jobs_file = argv[i+1];
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-B") )
+		{
+			manifest = argv[i+1];
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-G") )
+		{
+			group_size = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-g") )
+		{
+			//(read before MPI_Init)
+			i++;
+
+			if (progress == -1)
+			{
+				if (my_rank == 0)
+					printf("Unknown progress mode '%s' (use none, test or thread)\n", argv[i]);
+				MPI_Abort(MPI_COMM_WORLD, -1);
+			}
+		}
+		else if ( !strcmp(argv[i], "-e") )
+		{
+			exchange_type = halo_exchange_type_from_str(argv[i+1]);
+			i++;
+
+			if (exchange_type == -1)
+			{
+				if (my_rank == 0)
+					printf("Unknown halo exchange '%s' (use p2p, neighbour, shm, rma, delta or async)\n", argv[i]);
+				MPI_Abort(MPI_COMM_WORLD, -1);
+			}
+		}
 	}
 
 	if (N == -1 || M == -1)
@@ -101,7 +187,7 @@ int main(int argc, char* argv[])
 		if (INFO && my_rank == 0)
 		{
 			printf("Running with default matrix size %dx%d\n", N, M);
-			printf("Usage : 'mpiexec -n <process_num> ./gol_mpi -f <filename> -l <N> -c <M> -m <max_loops> -r <reduce_rate>\n");
+			printf("Usage : 'mpiexec -n <process_num> ./gol_mpi -f <filename> -l <N> -c <M> -m <max_loops> -r <reduce_rate> -e <p2p|neighbour|shm|rma|delta|async> -p <repartition_rate> -s <max_skew> -g <none|test|thread> [-E <jobs_file> -G <group_size>] [-B <manifest>]\n");
 		}
 	}
 	else
@@ -111,7 +197,7 @@ int main(int argc, char* argv[])
 			if (N == 0 || M == 0)
 			{
 				printf("Invalid arguments given!");	
-				printf("Usage : 'mpiexec -n <process_num> ./gol_mpi -f <filename> -l <N> -c <M> -m <max_loops> -r <reduce_rate>\n");
+				printf("Usage : 'mpiexec -n <process_num> ./gol_mpi -f <filename> -l <N> -c <M> -m <max_loops> -r <reduce_rate> -e <p2p|neighbour|shm|rma|delta|async> -p <repartition_rate> -s <max_skew> -g <none|test|thread> [-E <jobs_file> -G <group_size>] [-B <manifest>]\n");
 				printf("Aborting...\n");
 				MPI_Abort(MPI_COMM_WORLD, -1);
 			}
@@ -135,6 +221,81 @@ int main(int argc, char* argv[])
 	}
 
 
+	if (repartition_rate == -1)
+	{
+		repartition_rate = REPARTITION_RATE;
+
+		if ( INFO && my_rank == 0 )
+			printf("Running with default repartition rate %d\n", repartition_rate);
+	}
+
+	if (max_skew < 1)
+	{
+		max_skew = MAX_SKEW;
+
+		if ( INFO && my_rank == 0 )
+			printf("Running with default max skew %d\n", max_skew);
+	}
+
+	if (progress == HALO_PROGRESS_THREAD && thread_support < MPI_THREAD_MULTIPLE)
+	{
+		progress = HALO_PROGRESS_TEST;
+
+		if (my_rank == 0)
+			printf("MPI_THREAD_MULTIPLE is not supported, the halo exchange is progressed by the compute loop instead\n");
+	}
+
+	if ( INFO && my_rank == 0 )
+	{
+		printf("Running with halo exchange %s\n", halo_exchange_type_str(exchange_type));
+		printf("Running with progress mode %s\n", halo_progress_str(progress));
+	}
+
+	if (jobs_file != NULL)
+	{
+		play_ensemble(jobs_file, group_size, max_loops, reduce_rate,
+			exchange_type, repartition_rate, max_skew, progress);
+	}
+	else if (manifest != NULL)
+	{
+		play_batch(manifest, N, M, max_loops, reduce_rate,
+			exchange_type, repartition_rate, max_skew, progress);
+	}
+	else
+	{
+		unsigned int seed = time(NULL);
+		int stopped_at;
+		double elapsed;
+
+		play_game(MPI_COMM_WORLD, 1, &filename, &seed, N, M, max_loops, reduce_rate,
+			exchange_type, repartition_rate, max_skew, progress, &stopped_at, &elapsed);
+	}
+
+	MPI_Finalize();
+
+	return 0;
+
+}
+
+
+//Play games of life on the processes of game_comm (MPI_COMM_WORLD, or a group of an ensemble),
+//one for each input file (NULL to generate one from the seed), all of them NxM
+//stopped_at is the loop at which there was no change, or -1 if max_loops was reached
+//(the elapsed times are only set on the master process of game_comm)
+void play_game(MPI_Comm game_comm, int cases, char** filenames, unsigned int* seeds, int N, int M, int max_loops, int reduce_rate,
+	int exchange_type, int repartition_rate, int max_skew, int progress, int* stopped_at, double* elapsed_times)
+{
+	gol_array* ga1;
+	gol_array* ga2;
+	int i, j, c;
+	int my_rank, processors;
+	int tag = 201049;
+	MPI_Status status;
+	int coordinates[2];
+
+	MPI_Comm_size(game_comm, &processors);
+	MPI_Comm_rank(game_comm, &my_rank);
+
 	if (my_rank == 0 && INFO)
 		printf("N = %d\nM = %d\n", N, M);
 
@@ -192,29 +353,6 @@ int main(int argc, char* argv[])
 		printf("cols_per_block: %d\n", cols_per_block);
 	}
 
-	//Define our column derived data type
-	MPI_Datatype derived_type_block_col;
-
-	MPI_Type_vector(rows_per_block,    
-	   1,                  
-	   cols_per_block + 2,         
-	   MPI_SHORT,       
-	   &derived_type_block_col);       
-
-	MPI_Type_commit(&derived_type_block_col);
-
-	//Define block_array data type
-	//In case we want to gather all arrays to master
-	MPI_Datatype derived_type_block_array;
-
-	MPI_Type_vector(rows_per_block,    
-	   cols_per_block,                  
-	   cols_per_block + 2,         
-	   MPI_SHORT,       
-	   &derived_type_block_array);       
-
-	MPI_Type_commit(&derived_type_block_array);
-
 	/* SECTION B
 		Create our virtual topology
 		For the current proccess in the new topology
@@ -234,7 +372,28 @@ int main(int argc, char* argv[])
   	periods[1] = 1;
   	reorder = 1;
 
-  	int ret = MPI_Cart_create(MPI_COMM_WORLD, ndimansions, dimansion_size, periods, reorder, &virtual_comm);
+  	//most MPI libraries ignore reorder, so we order the processes ourselves:
+  	//the rank of a process in mapped_comm is the (row major) index of its block
+  	MPI_Comm mapped_comm = game_comm;
+
+  	if (NODE_MAPPING)
+  	{
+  		int tile_rows, tile_cols;
+  		int block_index = node_block_index(game_comm, blocks_per_row, blocks_per_col, &tile_rows, &tile_cols);
+
+  		MPI_Comm_split(game_comm, 0, block_index, &mapped_comm);
+  		reorder = 0;
+
+  		if (INFO && my_rank == 0)
+  		{
+  			if (tile_rows > 0)
+  				printf("Each node owns %dx%d blocks\n", tile_rows, tile_cols);
+  			else
+  				printf("Nodes can not own equal rectangles of blocks, keeping the rank order\n");
+  		}
+  	}
+
+  	int ret = MPI_Cart_create(mapped_comm, ndimansions, dimansion_size, periods, reorder, &virtual_comm);
   	MPI_Comm_rank(virtual_comm, &my_rank); //rank might have changed due to reorder
 
   	//find neighbour processes ranks
@@ -294,7 +453,19 @@ int main(int argc, char* argv[])
 	  	}
 	}
 
-  	//Calculate this process's boundaries
+	//Blocks start as equal as possible, but their boundaries (cuts) might move if we repartition
+	//The block with coords (i,j) has rows [row_cuts[i], row_cuts[i+1]) and cols [col_cuts[j], col_cuts[j+1])
+	//All the blocks of a row of blocks have the same rows (and of a col the same cols),
+	//so the neighbours stay the same whatever the cuts are
+	int* row_cuts = malloc((blocks_per_row + 1)*sizeof(int));
+	int* col_cuts = malloc((blocks_per_col + 1)*sizeof(int));
+
+	for (i=0; i<=blocks_per_row; i++)
+		row_cuts[i] = i * rows_per_block;
+	for (j=0; j<=blocks_per_col; j++)
+		col_cuts[j] = j * cols_per_block;
+
+	//Calculate this process's boundaries
 	int row_start, row_end, col_start, col_end;
   	
 	//we use the process's coordinates instead of its rank
@@ -338,84 +509,19 @@ int main(int argc, char* argv[])
 	} 	
 
 	//allocate and init two gol_arrays with two more rows and two more cols
-	ga1 = gol_array_init(rows_per_block + 2, cols_per_block + 2);
-	ga2 = gol_array_init(rows_per_block + 2, cols_per_block + 2);
-
-	//read/generate game of life array
-	//'scatter' game matrix (send the coordinates to the correct process)
-  	if (my_rank == 0) 
-  	{
+	//(in memory shared with the processes of our node, if their halos are read from there)
+	//(two of them, so that a new one can be made while repartitioning)
+	halo_exchange exchanges[2];
+	halo_exchange* hx = &exchanges[0];
 
-  		if (filename != NULL) 
-  		{
-  			gol_array_read_file_and_scatter(filename, ga1, processors, N, M, rows_per_block, cols_per_block, blocks_per_row, virtual_comm);
-  		}
-  		else 
-  		{//no input file given, generate a random game array
-  			if (INFO)
-  			{
-  				printf("No input file given as argument\n");
-  				printf("Generating a random game of life array to play\n");
-  			}
-  			gol_array_generate_and_scatter(ga1, processors, N, M, rows_per_block, cols_per_block, blocks_per_row, virtual_comm);
-        fprintf(stderr, "generate\n");
-  		}
-  	}
-  	else //for other processes besides master
-  	{
-  		//receive coordinates of alive cells, until we receive (-1,-1)
-  		short int** array = ga1->array;
-  		int finished = 0;
-
-  		while (!finished)
-  		{
-  			MPI_Recv(coordinates, 2, MPI_INT, 0, tag, MPI_COMM_WORLD, &status);
-  			if (DEBUG) {
-  				fprintf(stderr, "%d: I received (%d,%d)\n", my_rank, coordinates[0], coordinates[1]);
-  			}
-  			if (coordinates[0] == -1 && coordinates[1] == -1)
-  			{
-  				finished = 1;
-  			}
-  			else
-  			{
-          int x = coordinates[0] % rows_per_block + 1;
-          int y = coordinates[1] % cols_per_block + 1; 
-  				array[x][y] = 1;
-  			}
-  		}
-  	}
-
-  	//DEBUG PRINT FOR ARRAY SCATTER
-  	if (DEBUG)
-  	{
-  		char outname[20];
-  		mkdir("test_outs", 0777);
-  		sprintf(outname, "test_outs/out_%d", my_rank);
-
-  		FILE* out = fopen(outname, "w");
-
-	  	fprintf(out, "PROCESS %d ARRAY\n", my_rank);
-	  	int r,c;
-
-		for (r=row_start; r<=row_end; r++)
-		{
-			fputc('|', out);
-
-			for (c=col_start; c<=col_end; c++)
-			{
-				if (ga1->array[r][c] == 1)
-					fputc('o', out);
-				else
-					fputc(' ', out);
-
-				fputc('|', out);
-			}
-
-			fputc('\n', out);
-		}
-
-		fclose(out);
+	if (exchange_type == HALO_EXCHANGE_SHM)
+	{
+		halo_exchange_alloc_shared(hx, virtual_comm, rows_per_block + 2, cols_per_block + 2, &ga1, &ga2);
+	}
+	else
+	{
+		ga1 = gol_array_init(rows_per_block + 2, cols_per_block + 2);
+		ga2 = gol_array_init(rows_per_block + 2, cols_per_block + 2);
 	}
 
 	/* SECTION C
@@ -435,339 +541,551 @@ int main(int argc, char* argv[])
 	*/
 
 	//Define communication (requests) that will be made in each loop with MPI_Init
-	short int** array1 = ga1->array;
-	short int** array2 = ga2->array;
-	
-	//We need to define two types of requests
-	//Because the send/receive buffer is changed due to swapping after each loop/generation
-	
-	//Define tags to seperate messages
-	//Maybe up neighbour and down neighbour is the same process, or even it is ourselves..
-	//So we need to know which receive goes to which array position
-	int send_tags[8];
-	send_tags[0] = 1; //send up
-	send_tags[1] = 2; //send down
-	send_tags[2] = 3; //send left
-	send_tags[3] = 4; //send right
-	send_tags[4] = 5; //send up left
-	send_tags[5] = 6; //send up right
-	send_tags[6] = 7; //send down left
-	send_tags[7] = 8; //send down right
-
-	int receive_tags[8];
-	receive_tags[0] = send_tags[1];//receive up what neighbour sent down
-	receive_tags[1] = send_tags[0];
-	receive_tags[2] = send_tags[3];//receive left what neighbour sent right
-	receive_tags[3] = send_tags[2];
-	receive_tags[4] = send_tags[7];//receive up left what neighbour sent down right
-	receive_tags[5] = send_tags[6];
-	receive_tags[6] = send_tags[5];
-	receive_tags[7] = send_tags[4];
-
-	//first the send requests
-	MPI_Request send_request[2][8];
-	//rows
-	if (line_div != 1) {
-		MPI_Send_init( &array1[row_start][col_start], cols_per_block, MPI_SHORT, rank_u, send_tags[0], virtual_comm, &send_request[0][0]);
-		MPI_Send_init( &array1[row_end][col_start],   cols_per_block, MPI_SHORT, rank_d, send_tags[1], virtual_comm, &send_request[0][1]);
-		MPI_Send_init( &array2[row_start][col_start], cols_per_block, MPI_SHORT, rank_u, send_tags[0], virtual_comm, &send_request[1][0]);
-		MPI_Send_init( &array2[row_end][col_start],   cols_per_block, MPI_SHORT, rank_d, send_tags[1], virtual_comm, &send_request[1][1]);
-	}
-	else { //process has all the rows it needs
-		MPI_Send_init( &array1[row_start][col_start], cols_per_block, MPI_SHORT, MPI_PROC_NULL, send_tags[0], virtual_comm, &send_request[0][0]);
-		MPI_Send_init( &array1[row_end][col_start],   cols_per_block, MPI_SHORT, MPI_PROC_NULL, send_tags[1], virtual_comm, &send_request[0][1]);
-		MPI_Send_init( &array2[row_start][col_start], cols_per_block, MPI_SHORT, MPI_PROC_NULL, send_tags[0], virtual_comm, &send_request[1][0]);
-		MPI_Send_init( &array2[row_end][col_start],   cols_per_block, MPI_SHORT, MPI_PROC_NULL, send_tags[1], virtual_comm, &send_request[1][1]);
-	}
-	//cols
-	if (col_div != 1) {
-		MPI_Send_init( &array1[row_start][col_start], 1, derived_type_block_col, rank_l, send_tags[2], virtual_comm, &send_request[0][2]);
-		MPI_Send_init( &array1[row_start][col_end],   1, derived_type_block_col, rank_r, send_tags[3], virtual_comm, &send_request[0][3]);
-		MPI_Send_init( &array2[row_start][col_start], 1, derived_type_block_col, rank_l, send_tags[2], virtual_comm, &send_request[1][2]);
-		MPI_Send_init( &array2[row_start][col_end],   1, derived_type_block_col, rank_r, send_tags[3], virtual_comm, &send_request[1][3]);
-	}
-	else { // process has all the col it needs
-		MPI_Send_init( &array1[row_start][col_start], 1, derived_type_block_col, MPI_PROC_NULL, send_tags[2], virtual_comm, &send_request[0][2]);
-		MPI_Send_init( &array1[row_start][col_end],   1, derived_type_block_col, MPI_PROC_NULL, send_tags[3], virtual_comm, &send_request[0][3]);
-		MPI_Send_init( &array2[row_start][col_start], 1, derived_type_block_col, MPI_PROC_NULL, send_tags[2], virtual_comm, &send_request[1][2]);
-		MPI_Send_init( &array2[row_start][col_end],   1, derived_type_block_col, MPI_PROC_NULL, send_tags[3], virtual_comm, &send_request[1][3]);
-	}
-	//corners
-	if (line_div != 1 || col_div != 1) {
-		MPI_Send_init( &array1[row_start][col_start], 1, MPI_SHORT, rank_ul, send_tags[4], virtual_comm, &send_request[0][4]);
-		MPI_Send_init( &array1[row_start][col_end],   1, MPI_SHORT, rank_ur, send_tags[5], virtual_comm, &send_request[0][5]);
-		MPI_Send_init( &array1[row_end][col_start],   1, MPI_SHORT, rank_dl, send_tags[6], virtual_comm, &send_request[0][6]);
-		MPI_Send_init( &array1[row_end][col_end],     1, MPI_SHORT, rank_dr, send_tags[7], virtual_comm, &send_request[0][7]);
-		MPI_Send_init( &array2[row_start][col_start], 1, MPI_SHORT, rank_ul, send_tags[4], virtual_comm, &send_request[1][4]);
-		MPI_Send_init( &array2[row_start][col_end],   1, MPI_SHORT, rank_ur, send_tags[5], virtual_comm, &send_request[1][5]);
-		MPI_Send_init( &array2[row_end][col_start],   1, MPI_SHORT, rank_dl, send_tags[6], virtual_comm, &send_request[1][6]);
-		MPI_Send_init( &array2[row_end][col_end],     1, MPI_SHORT, rank_dr, send_tags[7], virtual_comm, &send_request[1][7]);
-	}
-	else {
-		MPI_Send_init( &array1[row_start][col_start], 1, MPI_SHORT, MPI_PROC_NULL, send_tags[4], virtual_comm, &send_request[0][4]);
-		MPI_Send_init( &array1[row_start][col_end],   1, MPI_SHORT, MPI_PROC_NULL, send_tags[5], virtual_comm, &send_request[0][5]);
-		MPI_Send_init( &array1[row_end][col_start],   1, MPI_SHORT, MPI_PROC_NULL, send_tags[6], virtual_comm, &send_request[0][6]);
-		MPI_Send_init( &array1[row_end][col_end],     1, MPI_SHORT, MPI_PROC_NULL, send_tags[7], virtual_comm, &send_request[0][7]);
-		MPI_Send_init( &array2[row_start][col_start], 1, MPI_SHORT, MPI_PROC_NULL, send_tags[4], virtual_comm, &send_request[1][4]);
-		MPI_Send_init( &array2[row_start][col_end],   1, MPI_SHORT, MPI_PROC_NULL, send_tags[5], virtual_comm, &send_request[1][5]);
-		MPI_Send_init( &array2[row_end][col_start],   1, MPI_SHORT, MPI_PROC_NULL, send_tags[6], virtual_comm, &send_request[1][6]);
-		MPI_Send_init( &array2[row_end][col_end],     1, MPI_SHORT, MPI_PROC_NULL, send_tags[7], virtual_comm, &send_request[1][7]);
-	}
-
-	//then the receive requests
-	MPI_Request recv_request[2][8];
-	int up_row = 0;
-	int down_row = row_end + 1;
-	int left_col = 0;
-	int right_col = col_end + 1;
-
-	//rows
-	if (line_div != 1) {
-		MPI_Recv_init( &array1[up_row][col_start],   cols_per_block, MPI_SHORT, rank_u, receive_tags[0], virtual_comm, &recv_request[0][0]);
-		MPI_Recv_init( &array1[down_row][col_start], cols_per_block, MPI_SHORT, rank_d, receive_tags[1], virtual_comm, &recv_request[0][1]);
-		MPI_Recv_init( &array2[up_row][col_start],   cols_per_block, MPI_SHORT, rank_u, receive_tags[0], virtual_comm, &recv_request[1][0]);
-		MPI_Recv_init( &array2[down_row][col_start], cols_per_block, MPI_SHORT, rank_d, receive_tags[1], virtual_comm, &recv_request[1][1]);
-	}
-	else {
-		MPI_Recv_init( &array1[up_row][col_start],   cols_per_block, MPI_SHORT, MPI_PROC_NULL, receive_tags[0], virtual_comm, &recv_request[0][0]);
-		MPI_Recv_init( &array1[down_row][col_start], cols_per_block, MPI_SHORT, MPI_PROC_NULL, receive_tags[1], virtual_comm, &recv_request[0][1]);
-		MPI_Recv_init( &array2[up_row][col_start],   cols_per_block, MPI_SHORT, MPI_PROC_NULL, receive_tags[0], virtual_comm, &recv_request[1][0]);
-		MPI_Recv_init( &array2[down_row][col_start], cols_per_block, MPI_SHORT, MPI_PROC_NULL, receive_tags[1], virtual_comm, &recv_request[1][1]);
-	}
-	//cols
-	if (col_div != 1) {
-		MPI_Recv_init( &array1[row_start][left_col],  1, derived_type_block_col, rank_l, receive_tags[2], virtual_comm, &recv_request[0][2]);
-		MPI_Recv_init( &array1[row_start][right_col], 1, derived_type_block_col, rank_r, receive_tags[3], virtual_comm, &recv_request[0][3]);
-		MPI_Recv_init( &array2[row_start][left_col],  1, derived_type_block_col, rank_l, receive_tags[2], virtual_comm, &recv_request[1][2]);
-		MPI_Recv_init( &array2[row_start][right_col], 1, derived_type_block_col, rank_r, receive_tags[3], virtual_comm, &recv_request[1][3]);
-	}
-	else {
-		MPI_Recv_init( &array1[row_start][left_col],  1, derived_type_block_col, MPI_PROC_NULL, receive_tags[2], virtual_comm, &recv_request[0][2]);
-		MPI_Recv_init( &array1[row_start][right_col], 1, derived_type_block_col, MPI_PROC_NULL, receive_tags[3], virtual_comm, &recv_request[0][3]);
-		MPI_Recv_init( &array2[row_start][left_col],  1, derived_type_block_col, MPI_PROC_NULL, receive_tags[2], virtual_comm, &recv_request[1][2]);
-		MPI_Recv_init( &array2[row_start][right_col], 1, derived_type_block_col, MPI_PROC_NULL, receive_tags[3], virtual_comm, &recv_request[1][3]);		
-	}
-	//corners
-	if (line_div != 1 || col_div != 1) {
-		MPI_Recv_init( &array1[up_row][left_col],  1, MPI_SHORT, rank_ul, receive_tags[4], virtual_comm, &recv_request[0][4]);
-		MPI_Recv_init( &array1[up_row][right_col], 1, MPI_SHORT, rank_ur, receive_tags[5], virtual_comm, &recv_request[0][5]);
-		MPI_Recv_init( &array1[down_row][left_col],  1, MPI_SHORT, rank_dl, receive_tags[6], virtual_comm, &recv_request[0][6]);
-		MPI_Recv_init( &array1[down_row][right_col], 1, MPI_SHORT, rank_dr, receive_tags[7], virtual_comm, &recv_request[0][7]);
-		MPI_Recv_init( &array2[up_row][left_col],  1, MPI_SHORT, rank_ul, receive_tags[4], virtual_comm, &recv_request[1][4]);
-		MPI_Recv_init( &array2[up_row][right_col], 1, MPI_SHORT, rank_ur, receive_tags[5], virtual_comm, &recv_request[1][5]);
-		MPI_Recv_init( &array2[down_row][left_col],  1, MPI_SHORT, rank_dl, receive_tags[6], virtual_comm, &recv_request[1][6]);
-		MPI_Recv_init( &array2[down_row][right_col], 1, MPI_SHORT, rank_dr, receive_tags[7], virtual_comm, &recv_request[1][7]);
-	}
-	else {
-		MPI_Recv_init( &array1[up_row][left_col],  1, MPI_SHORT, MPI_PROC_NULL, receive_tags[4], virtual_comm, &recv_request[0][4]);
-		MPI_Recv_init( &array1[up_row][right_col], 1, MPI_SHORT, MPI_PROC_NULL, receive_tags[5], virtual_comm, &recv_request[0][5]);
-		MPI_Recv_init( &array1[down_row][left_col],  1, MPI_SHORT, MPI_PROC_NULL, receive_tags[6], virtual_comm, &recv_request[0][6]);
-		MPI_Recv_init( &array1[down_row][right_col], 1, MPI_SHORT, MPI_PROC_NULL, receive_tags[7], virtual_comm, &recv_request[0][7]);
-		MPI_Recv_init( &array2[up_row][left_col],  1, MPI_SHORT, MPI_PROC_NULL, receive_tags[4], virtual_comm, &recv_request[1][4]);
-		MPI_Recv_init( &array2[up_row][right_col], 1, MPI_SHORT, MPI_PROC_NULL, receive_tags[5], virtual_comm, &recv_request[1][5]);
-		MPI_Recv_init( &array2[down_row][left_col],  1, MPI_SHORT, MPI_PROC_NULL, receive_tags[6], virtual_comm, &recv_request[1][6]);
-		MPI_Recv_init( &array2[down_row][right_col], 1, MPI_SHORT, MPI_PROC_NULL, receive_tags[7], virtual_comm, &recv_request[1][7]);
-	}
+	gol_cell** array1 = ga1->array;
+	gol_cell** array2 = ga2->array;
+	//the same arrays without the row pointer table, for the inner cells kernel (swapped along with them)
+	gol_grid grid1 = gol_array_block_grid(ga1, N, M);
+	gol_grid grid2 = gol_array_block_grid(ga2, N, M);
+
+	//neighbour ranks, in the order of the halo_exchange directions
+	//if the process has all the rows (or cols) it needs, there is no one to talk to
+	int neighbour_ranks[HALO_NEIGHBOURS];
+	neighbour_ranks[HALO_UP] = (line_div != 1) ? rank_u : MPI_PROC_NULL;
+	neighbour_ranks[HALO_DOWN] = (line_div != 1) ? rank_d : MPI_PROC_NULL;
+	neighbour_ranks[HALO_LEFT] = (col_div != 1) ? rank_l : MPI_PROC_NULL;
+	neighbour_ranks[HALO_RIGHT] = (col_div != 1) ? rank_r : MPI_PROC_NULL;
+	neighbour_ranks[HALO_UP_LEFT] = (line_div != 1 || col_div != 1) ? rank_ul : MPI_PROC_NULL;
+	neighbour_ranks[HALO_UP_RIGHT] = (line_div != 1 || col_div != 1) ? rank_ur : MPI_PROC_NULL;
+	neighbour_ranks[HALO_DOWN_LEFT] = (line_div != 1 || col_div != 1) ? rank_dl : MPI_PROC_NULL;
+	neighbour_ranks[HALO_DOWN_RIGHT] = (line_div != 1 || col_div != 1) ? rank_dr : MPI_PROC_NULL;
+
+	//persistent send/receive requests for both (swapped) arrays, or a neighbourhood collective
+	halo_exchange_init(hx, exchange_type, virtual_comm, neighbour_ranks, rows_per_block, cols_per_block, ga1, ga2, max_skew, progress);
 
 	int count;
 	int no_change;
 	int no_change_sum;
+	int terminated = 0;
+	int terminated_at = -1; //the loop with no change
+
+	//The termination check of a generation is reduced while the next max_skew ones are computed.
+	//If there was no change, the next generations gave the same array, so they are thrown away (rollback)
+	//and we terminate max_skew generations late with the same result.
+	//The checks in flight are a queue of max_skew slots, the oldest one is reduce_head
+	int* reduce_send = malloc(max_skew*sizeof(int)); //no_change of the generation being reduced
+	int* no_change_sums = malloc(max_skew*sizeof(int));
+	int* reduce_count = malloc(max_skew*sizeof(int)); //generation being reduced
+	MPI_Request* reduce_request = malloc(max_skew*sizeof(MPI_Request));
+	int reduce_head = 0;
+	int reduce_pending = 0;
+
+#if MPI_VERSION >= 4
+	for (i=0; i<max_skew; i++)
+		MPI_Allreduce_init(&reduce_send[i], &no_change_sums[i], 1, MPI_INT, MPI_SUM, virtual_comm, MPI_INFO_NULL, &reduce_request[i]);
+#endif
 
 	int communication_type = 0; //switches between 0 and 1 after each loop
-	MPI_Status statuses[8];
 
-	MPI_Barrier(MPI_COMM_WORLD);
+	//A block that did not change is not computed again while its halos stay the same
+	//(only the delta halo exchange knows that they did, the others always compute the border)
+	int block_static = 0;
+	int skipped_loops = 0;
+
+	//time spent on the inner cells (while the halos are in flight) and waiting for the halos
+	double phase_start;
+	double inner_time = 0;
+	double wait_time = 0;
+
+	//changed cells of each of our rows and cols, since the last repartition
+	int* changed_rows = calloc(rows_per_block + 2, sizeof(int));
+	int* changed_cols = calloc(cols_per_block + 2, sizeof(int));
+	long* row_weights = malloc(N*sizeof(long));
+	long* col_weights = malloc(M*sizeof(long));
+	int* new_row_cuts = malloc((blocks_per_row + 1)*sizeof(int));
+	int* new_col_cuts = malloc((blocks_per_col + 1)*sizeof(int));
+
+	//Play the cases one after the other on the same blocks, datatypes and requests
+	for (c=0; c<cases; c++)
+	{
+		//everything but the cells is kept from the previous case
+		memset(ga1->flat_array, 0, (size_t) (rows_per_block + 2)*(cols_per_block + 2)*sizeof(gol_cell));
+		memset(ga2->flat_array, 0, (size_t) (rows_per_block + 2)*(cols_per_block + 2)*sizeof(gol_cell));
+		array1 = ga1->array;
+		array2 = ga2->array;
+		grid1 = gol_array_block_grid(ga1, N, M);
+		grid2 = gol_array_block_grid(ga2, N, M);
+		communication_type = 0;
+		terminated = 0;
+		terminated_at = -1;
+		block_static = 0;
+		skipped_loops = 0;
+		inner_time = 0;
+		wait_time = 0;
+		memset(changed_rows, 0, (rows_per_block + 2)*sizeof(int));
+		memset(changed_cols, 0, (cols_per_block + 2)*sizeof(int));
+
+		char* filename = filenames[c];
+		unsigned int seed = seeds[c];
+
+		//read/generate the game of life array of this case
+		//'scatter' game matrix (send the coordinates to the correct process)
+	  	if (my_rank == 0) 
+	  	{
 
-	double start, finish;
-  gol_array* whole_array;
+	  		if (filename != NULL) 
+	  		{
+	  			gol_array_read_file_and_scatter(filename, ga1, processors, N, M, row_cuts, col_cuts, blocks_per_row, blocks_per_col, virtual_comm);
+	  		}
+	  		else 
+	  		{//no input file given, generate a random game array
+	  			if (INFO)
+	  			{
+	  				printf("No input file given as argument\n");
+	  				printf("Generating a random game of life array to play\n");
+	  			}
+	  			gol_array_generate_and_scatter(ga1, seed, processors, N, M, row_cuts, col_cuts, blocks_per_row, blocks_per_col, virtual_comm);
+	        fprintf(stderr, "generate\n");
+	  		}
+	  	}
+	  	else //for other processes besides master
+	  	{
+	  		//receive coordinates of alive cells, until we receive (-1,-1)
+	  		gol_cell** array = ga1->array;
+	  		int finished = 0;
 
-	if (PRINT_INITIAL)
-	{
-    whole_array = gol_array_init(N, M);
-    short int** array = whole_array->array;
-		gol_array_gather(array, array1, my_rank, processors, row_start, col_start,
-			blocks_per_row, blocks_per_col, rows_per_block, cols_per_block, derived_type_block_array, virtual_comm);
-		if (my_rank == 0) {
-			printf("Printing initial array:\n\n");
-			fflush(stdout);
-			print_array(array, N, M);
-			fflush(stdout);
-			putchar('\n');
-		}
-    gol_array_free(&whole_array);	
-	}
+	  		while (!finished)
+	  		{
+	  			MPI_Recv(coordinates, 2, MPI_INT, 0, tag, virtual_comm, &status);
+	  			if (DEBUG) {
+	  				fprintf(stderr, "%d: I received (%d,%d)\n", my_rank, coordinates[0], coordinates[1]);
+	  			}
+	  			if (coordinates[0] == -1 && coordinates[1] == -1)
+	  			{
+	  				finished = 1;
+	  			}
+	  			else
+	  			{
+	          int x = coordinates[0] - row_cuts[my_coords[0]] + 1;
+	          int y = coordinates[1] - col_cuts[my_coords[1]] + 1;
+	  				array[x][y] = 1;
+	  			}
+	  		}
+	  	}
 
-  if (PRINT_STEPS) {
-    whole_array = gol_array_init(N, M);
-  }
+	  	//DEBUG PRINT FOR ARRAY SCATTER
+	  	if (DEBUG)
+	  	{
+	  		char outname[20];
+	  		mkdir("test_outs", 0777);
+	  		sprintf(outname, "test_outs/out_%d", my_rank);
 
-	if (STATUS && my_rank == 0)
-		printf("Starting the Game of Life\n");
+	  		FILE* out = fopen(outname, "w");
 
-	start = MPI_Wtime();
+		  	fprintf(out, "PROCESS %d ARRAY\n", my_rank);
+		  	int r,c;
 
-	for(count = 0; count < max_loops; count++) 
-	{
-		no_change = 1;
+			for (r=row_start; r<=row_end; r++)
+			{
+				fputc('|', out);
+
+				for (c=col_start; c<=col_end; c++)
+				{
+					if (ga1->array[r][c] == 1)
+						fputc('o', out);
+					else
+						fputc(' ', out);
+
+					fputc('|', out);
+				}
+
+				fputc('\n', out);
+			}
+
+			fclose(out);
+		}
 
-		//8 Isend
-		MPI_Startall(8, send_request[communication_type]);
-		//8 IRecv
-		MPI_Startall(8, recv_request[communication_type]);
+		//the kernels have not written the left/right edges of the new cells
+		halo_exchange_pack_sides(hx, 0);
+		halo_exchange_pack_sides(hx, 1);
 
-		//calculate/populate 'inner' cells
-		for (i=row_start + 1; i<= row_end - 1; i++) {
-			for (j= col_start + 1; j <= col_end - 1; j++) {
-				//for each cell/organism
+		MPI_Barrier(game_comm);
 
-				//for each cell/organism
-				//see if there is a change
-				//populate functions applies the game's rules
-				//and returns 0 if a change occurs
-				if (populate(array1, array2, N, M, i, j) == 0)
-					no_change = 0;	
+		double start, finish;
+	  gol_array* whole_array;
+
+		if (PRINT_INITIAL)
+		{
+	    whole_array = gol_array_init(N, M);
+	    gol_cell** array = whole_array->array;
+			gol_array_gather(array, array1, my_rank, blocks_per_row, blocks_per_col, row_cuts, col_cuts, virtual_comm);
+			if (my_rank == 0) {
+				printf("Printing initial array:\n\n");
+				fflush(stdout);
+				print_array(array, N, M);
+				fflush(stdout);
+				putchar('\n');
 			}
+	    gol_array_free(&whole_array);	
 		}
 
-		//wait for recvs
-		MPI_Waitall(8, recv_request[communication_type], statuses);
+	  if (PRINT_STEPS) {
+	    whole_array = gol_array_init(N, M);
+	  }
+
+		if (STATUS && my_rank == 0)
+			printf("Starting the Game of Life\n");
+
+		start = MPI_Wtime();
+
+		for(count = 0; count < max_loops; count++) 
+		{
+			no_change = 1;
+
+			//move the block boundaries to where the work is
+			if (repartition_rate > 0 && count > 0 && count % repartition_rate == 0)
+			{
+				//cost of every row (col) of the whole game: its cells plus its changes
+				activity_weights(row_weights, N, changed_rows, row_cuts[my_coords[0]], rows_per_block,
+					(long) repartition_rate * M, virtual_comm);
+				activity_weights(col_weights, M, changed_cols, col_cuts[my_coords[1]], cols_per_block,
+					(long) repartition_rate * N, virtual_comm);
+
+				//every process gets the same weights, so every process makes the same decision
+				int rows_moved = balance_cuts(row_weights, blocks_per_row, row_cuts, new_row_cuts);
+				int cols_moved = balance_cuts(col_weights, blocks_per_col, col_cuts, new_col_cuts);
+
+				if (rows_moved || cols_moved)
+				{
+					gol_array* current = (communication_type == 0) ? ga1 : ga2;
+					halo_exchange* new_hx = (hx == &exchanges[0]) ? &exchanges[1] : &exchanges[0];
+					gol_array* new_ga1;
+					gol_array* new_ga2;
+
+					rows_per_block = new_row_cuts[my_coords[0] + 1] - new_row_cuts[my_coords[0]];
+					cols_per_block = new_col_cuts[my_coords[1] + 1] - new_col_cuts[my_coords[1]];
+
+					if (exchange_type == HALO_EXCHANGE_SHM)
+					{
+						halo_exchange_alloc_shared(new_hx, virtual_comm, rows_per_block + 2, cols_per_block + 2, &new_ga1, &new_ga2);
+					}
+					else
+					{
+						new_ga1 = gol_array_init(rows_per_block + 2, cols_per_block + 2);
+						new_ga2 = gol_array_init(rows_per_block + 2, cols_per_block + 2);
+					}
+
+					//send the parts of our block that other processes own now, receive the parts of our new block
+					gol_array_migrate(current, new_ga1, my_coords, blocks_per_row, blocks_per_col,
+						row_cuts, col_cuts, new_row_cuts, new_col_cuts, virtual_comm);
+
+					//and make the requests again for the new arrays
+					halo_exchange_free(hx);
+					gol_array_free(&ga1);
+					gol_array_free(&ga2);
+
+					ga1 = new_ga1;
+					ga2 = new_ga2;
+					hx = new_hx;
+					halo_exchange_init(hx, exchange_type, virtual_comm, neighbour_ranks, rows_per_block, cols_per_block, ga1, ga2, max_skew, progress);
+
+					array1 = ga1->array;
+					array2 = ga2->array;
+					grid1 = gol_array_block_grid(ga1, N, M);
+					grid2 = gol_array_block_grid(ga2, N, M);
+					communication_type = 0;
+					block_static = 0;
+					row_end = rows_per_block;
+					col_end = cols_per_block;
+					memcpy(row_cuts, new_row_cuts, (blocks_per_row + 1)*sizeof(int));
+					memcpy(col_cuts, new_col_cuts, (blocks_per_col + 1)*sizeof(int));
+
+					changed_rows = realloc(changed_rows, (rows_per_block + 2)*sizeof(int));
+					changed_cols = realloc(changed_cols, (cols_per_block + 2)*sizeof(int));
+
+					if (INFO && my_rank == 0)
+					{
+						printf("Loop %d: repartitioned, our block is %dx%d\n", count, rows_per_block, cols_per_block);
+					}
+				}
+
+				memset(changed_rows, 0, (rows_per_block + 2)*sizeof(int));
+				memset(changed_cols, 0, (cols_per_block + 2)*sizeof(int));
+			}
+
+			//8 Isend, 8 IRecv (or one neighbourhood collective)
+			halo_exchange_start(hx, communication_type);
+
+			//calculate/populate 'inner' cells
+			//(if our block did not change, the next generation of the inner cells is already in array2)
+			phase_start = MPI_Wtime();
+
+			if (!block_static)
+			{
+				for (i=row_start + 1; i<= row_end - 1; i++) {
+					//a row of cells/organisms at a time
+					//populate_row applies the game's rules
+					//and returns how many of them changed
+					int changes = populate_row(grid1, grid2, i, col_start + 1, col_end - 1, changed_cols);
+					if (changes != 0)
+					{
+						no_change = 0;
+						changed_rows[i] += changes;
+					}
+
+					//let MPI move the halos forward every few rows
+					if (progress == HALO_PROGRESS_TEST && i % PROGRESS_ROWS == 0)
+						halo_exchange_progress(hx, communication_type);
+				}
+			}
+
+			inner_time += MPI_Wtime() - phase_start;
 
-		//calculate/populate 'outer' cells
+			//wait for recvs
+			phase_start = MPI_Wtime();
+			halo_exchange_wait_recvs(hx, communication_type);
+			wait_time += MPI_Wtime() - phase_start;
+
+			//calculate/populate 'outer' cells
+			//(the same goes for them, unless a halo changed)
+			if (!block_static || hx->halos_changed)
+			{
+				int next_type = (communication_type + 1) % 2;
 		
-		//up/down row
-		for (j= col_start; j <= col_end; j++) {
-			if (populate(array1, array2, N, M, row_start, j) == 0)
-				no_change = 0;
-			if (populate(array1, array2, N, M, row_end, j) == 0)
-				no_change = 0;
-		}
-
-		//left/right col
-		for (i=row_start; i<= row_end; i++) {
-			if (populate(array1, array2, N, M, i, col_start) == 0)
-				no_change = 0;
-			if (populate(array1, array2, N, M, i, col_end) == 0)
-				no_change = 0;
-		}
-
-		//corners
-		if (populate(array1, array2, N, M, row_start, col_start) == 0)
-				no_change = 0;
-		if (populate(array1, array2, N, M, row_start, col_end) == 0)
-				no_change = 0;
-		if (populate(array1, array2, N, M, row_end, col_start) == 0)
-				no_change = 0;
-		if (populate(array1, array2, N, M, row_end, col_end) == 0)
-				no_change = 0;
-
-
-		if ( reduce_rate > 0 && (count + 1) % reduce_rate == 0)
-		{			
-			MPI_Allreduce(&no_change, &no_change_sum, 1, MPI_SHORT, MPI_SUM, virtual_comm);
-			if (no_change_sum == processors )
+				//up/down row, with the corners
+				int changes = populate_row(grid1, grid2, row_start, col_start, col_end, changed_cols);
+				changed_rows[row_start] += changes;
+
+				//(a block one row thin has them once)
+				if (row_end != row_start)
+				{
+					int row_changes = populate_row(grid1, grid2, row_end, col_start, col_end, changed_cols);
+					changed_rows[row_end] += row_changes;
+					changes += row_changes;
+				}
+
+				//left/right col, between them
+				int col_changes = populate_col(grid1, grid2, col_start, row_start + 1, row_end - 1, changed_rows);
+				changed_cols[col_start] += col_changes;
+				changes += col_changes;
+
+				if (col_end != col_start)
+				{
+					col_changes = populate_col(grid1, grid2, col_end, row_start + 1, row_end - 1, changed_rows);
+					changed_cols[col_end] += col_changes;
+					changes += col_changes;
+				}
+
+				if (changes != 0)
+					no_change = 0;
+
+				//the left/right col are also written to the contiguous buffers they are sent from in the next loop
+				gol_cell* left_edge = hx->side_edges[next_type][HALO_LEFT];
+				gol_cell* right_edge = hx->side_edges[next_type][HALO_RIGHT];
+
+				for (i=row_start; i<= row_end; i++) {
+					left_edge[i - row_start] = *gol_grid_cell(grid2, i, col_start);
+					right_edge[i - row_start] = *gol_grid_cell(grid2, i, col_end);
+				}
+			}
+			else
 			{
-				if (my_rank == 0 && STATUS) 
-					printf("Terminating because there was no change at loop number %d\n", count);
+				skipped_loops++;
+			}
 
-				break;
+			//the next generation can skip our block if nothing changed in this one
+			block_static = no_change;
+
+			//complete the termination check of the generation max_skew generations ago
+			if (reduce_pending > 0 && reduce_count[reduce_head] <= count - max_skew)
+			{
+				MPI_Wait(&reduce_request[reduce_head], MPI_STATUS_IGNORE);
+				int checked_count = reduce_count[reduce_head];
+				no_change_sum = no_change_sums[reduce_head];
+				reduce_head = (reduce_head + 1) % max_skew;
+				reduce_pending--;
+
+				if (no_change_sum == processors)
+				{
+					if (my_rank == 0 && STATUS) 
+						printf("Terminating because there was no change at loop number %d\n", checked_count);
+
+					terminated = 1;
+					terminated_at = checked_count;
+					halo_exchange_wait_sends(hx, communication_type);
+					break;
+				}
+			}
+
+			if ( reduce_rate > 0 && (count + 1) % reduce_rate == 0)
+			{
+				int slot = (reduce_head + reduce_pending) % max_skew;
+
+				reduce_send[slot] = no_change;
+				reduce_count[slot] = count;
+				reduce_pending++;
+	#if MPI_VERSION >= 4
+				MPI_Start(&reduce_request[slot]);
+	#else
+				MPI_Iallreduce(&reduce_send[slot], &no_change_sums[slot], 1, MPI_INT, MPI_SUM, virtual_comm, &reduce_request[slot]);
+	#endif
 			}
 
+			//wait for sends
+			phase_start = MPI_Wtime();
+			halo_exchange_wait_sends(hx, communication_type);
+			wait_time += MPI_Wtime() - phase_start;
+
+			//only the master process prints
+			if (PRINT_STEPS) {
+	      gol_cell** array = whole_array->array;
+				gol_array_gather(array, array2, my_rank, blocks_per_row, blocks_per_col, row_cuts, col_cuts, virtual_comm);
+				if (my_rank == 0) {
+					fflush(stdout);
+					print_array(array, N, M);
+					fflush(stdout);
+				}
+				putchar('\n');
+			}
+
+			//swap arrays (array2 becomes array1)
+			gol_cell** temp;
+			temp = array1;
+			array1 = array2;
+			array2 = temp;
+			gol_grid temp_grid = grid1;
+			grid1 = grid2;
+			grid2 = temp_grid;
+			communication_type = (communication_type + 1) % 2;
+
 		}
 
-		//wait for sends
-		MPI_Waitall(8, send_request[communication_type], statuses);
 
-		//only the master process prints
-		if (PRINT_STEPS) {
-      short int** array = whole_array->array;
-			gol_array_gather(array, array2, my_rank, processors, row_start, col_start,
-			blocks_per_row, blocks_per_col, rows_per_block, cols_per_block, derived_type_block_array, virtual_comm);
-			if (my_rank == 0) {
-				fflush(stdout);
-				print_array(array, N, M);
-				fflush(stdout);
+		//the checks of the last generations are still in flight
+		//(if we have terminated, they can only agree)
+		while (reduce_pending > 0)
+		{
+			MPI_Wait(&reduce_request[reduce_head], MPI_STATUS_IGNORE);
+
+			if (!terminated && no_change_sums[reduce_head] == processors)
+			{
+				if (my_rank == 0 && STATUS) 
+					printf("Terminating because there was no change at loop number %d\n", reduce_count[reduce_head]);
+
+				terminated = 1;
+				terminated_at = reduce_count[reduce_head];
 			}
-			putchar('\n');
+
+			reduce_head = (reduce_head + 1) % max_skew;
+			reduce_pending--;
 		}
 
-		//swap arrays (array2 becomes array1)
-		short int** temp;
-		temp = array1;
-		array1 = array2;
-		array2 = temp;
-		communication_type = (communication_type + 1) % 2;
 
-	}
+		if (my_rank == 0) 
+		{
+			if (my_rank == 0 && !terminated && STATUS)
+			{
+				printf("Max loop number (%d) was reached. Terminating Game of Life\n", max_loops);
+			}
+		}
 
+		finish = MPI_Wtime();
 
-	if (my_rank == 0) 
-	{
-		if (my_rank == 0 && no_change == 0 && STATUS)
+		double local_elapsed, elapsed;
+		local_elapsed = finish - start;
+
+		if (INFO)
 		{
-			printf("Max loop number (%d) was reached. Terminating Game of Life\n", max_loops);
+			printf("Process %d > Time elapsed: %f seconds\n", my_rank, local_elapsed);
+			printf("Process %d > Skipped %d loops of a static block\n", my_rank, skipped_loops);
 		}
-	}
 
-	finish = MPI_Wtime();
+		//reduce to check if the array has changed every reduce_rate loops
+		MPI_Reduce(&local_elapsed, &elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, game_comm);
 
-	double local_elapsed, elapsed;
-	local_elapsed = finish - start;
+		if (TIME && my_rank == 0)
+			printf("Time elapsed: %f seconds\n", elapsed);
 
-	if (INFO)
-		printf("Process %d > Time elapsed: %f seconds\n", my_rank, local_elapsed);
+		//the share of the exchange that was hidden behind the inner cells (of the process that hid the least)
+		double overlap = (inner_time + wait_time > 0) ? inner_time / (inner_time + wait_time) : 1;
+		double min_overlap, max_wait_time;
 
-	//reduce to check if the array has changed every reduce_rate loops
-	MPI_Reduce(&local_elapsed, &elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+		if (INFO)
+			printf("Process %d > Inner cells: %f seconds, waiting for halos: %f seconds\n", my_rank, inner_time, wait_time);
 
-	if (TIME && my_rank == 0)
-		printf("Time elapsed: %f seconds\n", elapsed);
+		MPI_Reduce(&overlap, &min_overlap, 1, MPI_DOUBLE, MPI_MIN, 0, game_comm);
+		MPI_Reduce(&wait_time, &max_wait_time, 1, MPI_DOUBLE, MPI_MAX, 0, game_comm);
 
-	if (PRINT_FINAL)
-	{
-		//Gather the whole (final) gol array into master so he can print it out
-    if (!PRINT_STEPS) {
-      whole_array = gol_array_init(rows_per_block + 2, cols_per_block + 2);
-    }
-    short int** array = whole_array->array;
-		gol_array_gather(array, array1, my_rank, processors, row_start, col_start,
-			blocks_per_row, blocks_per_col, rows_per_block, cols_per_block, derived_type_block_array, virtual_comm);
-		if (my_rank == 0) {
-			fflush(stdout);
-			print_array(array, N, M);
-			fflush(stdout);
+		if (TIME && my_rank == 0)
+			printf("Waiting for halos: %f seconds (%.1f%% overlap with computation)\n", max_wait_time, 100*min_overlap);
+
+		if (PRINT_FINAL)
+		{
+			//Gather the whole (final) gol array into master so he can print it out
+	    if (!PRINT_STEPS) {
+	      whole_array = gol_array_init(N, M);
+	    }
+	    gol_cell** array = whole_array->array;
+			gol_array_gather(array, array1, my_rank, blocks_per_row, blocks_per_col, row_cuts, col_cuts, virtual_comm);
+			if (my_rank == 0) {
+				fflush(stdout);
+				print_array(array, N, M);
+				fflush(stdout);
+			}
+	    if (!PRINT_STEPS) {
+	      gol_array_free(&whole_array);
+	    }
 		}
-    if (!PRINT_STEPS) {
-      gol_array_free(&whole_array);
-    }
+
+	  if (PRINT_STEPS) {
+	    gol_array_free(&whole_array);
+	  }
+
+		stopped_at[c] = terminated_at;
+		elapsed_times[c] = elapsed;
 	}
 
+#if MPI_VERSION >= 4
+	for (i=0; i<max_skew; i++)
+		MPI_Request_free(&reduce_request[i]);
+#endif
+	free(reduce_send);
+	free(no_change_sums);
+	free(reduce_count);
+	free(reduce_request);
+
+	halo_exchange_free(hx);
+
+	free(row_cuts);
+	free(col_cuts);
+	free(new_row_cuts);
+	free(new_col_cuts);
+	free(changed_rows);
+	free(changed_cols);
+	free(row_weights);
+	free(col_weights);
+
 	//free arrays
 	gol_array_free(&ga1);
 	gol_array_free(&ga2);
 
-  if (PRINT_STEPS) {
-    gol_array_free(&whole_array);
-  }
-
-	MPI_Finalize();
-
-	return 0;
-
+	MPI_Comm_free(&virtual_comm);
+	if (mapped_comm != game_comm)
+		MPI_Comm_free(&mapped_comm);
 }
 
 
 void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int processors, int lines, int columns,
-										int rows_per_block, int cols_per_block, int blocks_per_row, MPI_Comm virtual_comm)
+										int* row_cuts, int* col_cuts, int blocks_per_row, int blocks_per_col, MPI_Comm virtual_comm)
 {
-	short int** array = gol_ar->array;
+	gol_cell** array = gol_ar->array;
 	int N = lines;
 	int M = columns;
 	int tag = 201049;
 
 	char line[100];
 	char copy[100];
-	int counter = 0;
-	int successful = 0;
+	long counter = 0;
+	long successful = 0;
 	int row_of_block;
 	int col_of_block;
 	int destination_process;
@@ -805,7 +1123,7 @@ void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int proc
 
 		if (token == NULL)
 		{
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -816,7 +1134,7 @@ void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int proc
 
 		if (token == NULL)
 		{
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -826,14 +1144,14 @@ void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int proc
 		if (row < 1 || row > N || col < 1 || col > M)
 		{
 			printf("Invalid row or column\n");
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
 		successful++;
 
-		row_of_block = (row - 1) / rows_per_block;
-		col_of_block = (col - 1) / cols_per_block;
+		row_of_block = block_of(row - 1, row_cuts, blocks_per_row);
+		col_of_block = block_of(col - 1, col_cuts, blocks_per_col);
 		int neighbour_coords[2];
 		neighbour_coords[0] = row_of_block;
 		neighbour_coords[1] = col_of_block;
@@ -850,7 +1168,7 @@ void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int proc
 			//send the coordinates
 			coordinates[0] = row - 1;
 			coordinates[1] = col - 1;
-			MPI_Send(coordinates, 2, MPI_INT, destination_process, tag, MPI_COMM_WORLD);
+			MPI_Send(coordinates, 2, MPI_INT, destination_process, tag, virtual_comm);
 		}
 
 	}
@@ -861,17 +1179,17 @@ void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int proc
 
 	//send 'ok' message to all processes
 	for (i=1; i<processors; i++)
-		MPI_Send(coordinates, 2, MPI_INT, i, tag, MPI_COMM_WORLD);
+		MPI_Send(coordinates, 2, MPI_INT, i, tag, virtual_comm);
 
 
 	if (INFO)
-		printf("\nSuccesfully read %d coordinates\n", successful);
+		printf("\nSuccesfully read %ld coordinates\n", successful);
 	fclose(file);
 }
 
 
-void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines, int columns,
-										int rows_per_block, int cols_per_block, int blocks_per_row, MPI_Comm virtual_comm)
+void gol_array_generate_and_scatter(gol_array* gol_ar, unsigned int seed, int processors, int lines, int columns,
+										int* row_cuts, int* col_cuts, int blocks_per_row, int blocks_per_col, MPI_Comm virtual_comm)
 {
   FILE* file;
   if (SAVE_GENERATED)
@@ -892,11 +1210,11 @@ void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines
   	}
   }
 
-	short int** array = gol_ar->array;
+	gol_cell** array = gol_ar->array;
 
-	srand(time(NULL));
-	int alive_count = rand() % (lines*columns + 1);
-	int i;
+	srand(seed);
+	long alive_count = random_below((long) lines*columns + 1);
+	long i;
 	int tag = 201049;
 	int row_of_block;
 	int col_of_block;
@@ -914,8 +1232,8 @@ void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines
       fprintf(file, "%d %d\n", x+1, y+1);
     }
 
-    row_of_block = x / rows_per_block;
-    col_of_block = y / cols_per_block;
+    row_of_block = block_of(x, row_cuts, blocks_per_row);
+    col_of_block = block_of(y, col_cuts, blocks_per_col);
     int neighbour_coords[2];
     neighbour_coords[0] = row_of_block;
     neighbour_coords[1] = col_of_block;
@@ -931,7 +1249,7 @@ void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines
     {
     	coordinates[0] = x;
     	coordinates[1] = y;
-    	MPI_Send(coordinates, 2, MPI_INT, destination_process, tag, MPI_COMM_WORLD);
+    	MPI_Send(coordinates, 2, MPI_INT, destination_process, tag, virtual_comm);
     }
 
   	// array[x][y] = 1;
@@ -941,7 +1259,7 @@ void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines
 	coordinates[1] = -1;
 
 	for (i=1; i<processors; i++)
-		MPI_Send(coordinates, 2, MPI_INT, i, tag, MPI_COMM_WORLD);
+		MPI_Send(coordinates, 2, MPI_INT, i, tag, virtual_comm);
 
   if (SAVE_GENERATED) {
 	 fclose(file);
@@ -949,57 +1267,539 @@ void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines
 }
 
 
-void gol_array_gather(short int** array, short int** myarray, int my_rank, int processes, int row_start, int col_start,
-	int blocks_per_row, int blocks_per_col, int rows_per_block, int cols_per_block, MPI_Datatype block_array, MPI_Comm virtual_comm)
+void gol_array_gather(gol_cell** array, gol_cell** myarray, int my_rank, int blocks_per_row, int blocks_per_col,
+	int* row_cuts, int* col_cuts, MPI_Comm virtual_comm)
 {
 	int tag = 201400201;
-  gol_array* block_gol_array = gol_array_init(rows_per_block + 2, cols_per_block + 2);
-  short int** neighbour_block_array = block_gol_array->array;
+	int neighbour_coords[2];
+	int i, r;
 
 	if (my_rank == 0)
 	{
-    //copy master processes array to whole array
-
-    for (int i = 0; i < rows_per_block; i++)
-    {
-      memcpy(&(array[i][0]), &(myarray[i+1][1]), cols_per_block*sizeof(short int));
-    }
-
 		MPI_Status status;
-		int i, j;
+		int j;
 		int receive_process;
-		int neighbour_coords[2];
 		int neigbour_rstart;
 		int neigbour_cstart;
+		int neighbour_rows;
+		int neighbour_cols;
+		gol_cell* block = malloc((size_t) row_cuts[blocks_per_row] * col_cuts[blocks_per_col] * sizeof(gol_cell));
+		MPI_Datatype block_row;
 
 		for (i = 0; i < blocks_per_row; i++) {
 			for (j = 0; j < blocks_per_col; j++) {
-				if (i != 0 || j != 0) {
-					neigbour_rstart = i * rows_per_block;
-					neigbour_cstart = j * cols_per_block;
-					neighbour_coords[0] = i;
-					neighbour_coords[1] = j;
-					MPI_Cart_rank(virtual_comm, neighbour_coords, &receive_process);
+				neigbour_rstart = row_cuts[i];
+				neigbour_cstart = col_cuts[j];
+				neighbour_rows = row_cuts[i+1] - row_cuts[i];
+				neighbour_cols = col_cuts[j+1] - col_cuts[j];
+				neighbour_coords[0] = i;
+				neighbour_coords[1] = j;
+				MPI_Cart_rank(virtual_comm, neighbour_coords, &receive_process);
+
+				if (receive_process == 0)
+				{
+					//copy master processes array to whole array
+					for (r = 0; r < neighbour_rows; r++)
+					{
+						memcpy(&(array[neigbour_rstart + r][neigbour_cstart]), &(myarray[r+1][1]), neighbour_cols*sizeof(gol_cell));
+					}
+				}
+				else
+				{
 					if (DEBUG) {
 						fprintf(stderr, "Receiving from %d starting from row %d and col %d\n", receive_process, neigbour_rstart, neigbour_cstart);
 					}
-					MPI_Recv(&(neighbour_block_array[1][1]), 1, block_array,
-					 receive_process, tag, virtual_comm, &status);
-          int neighbour_row = neigbour_rstart;
-          for (int i = 1; i <= rows_per_block; i++)
-          {
-            memcpy(&(array[neighbour_row][neigbour_cstart]),
-                    &(neighbour_block_array[i][1]), cols_per_block*sizeof(short int));
-            neighbour_row++;
-          }
+					//the block comes without its extra rows/cols, row after row
+					//(counted in rows, as a block can have more than 2^31 cells)
+					MPI_Type_contiguous(neighbour_cols, GOL_CELL_MPI, &block_row);
+					MPI_Type_commit(&block_row);
+					MPI_Recv(block, neighbour_rows, block_row, receive_process, tag, virtual_comm, &status);
+					MPI_Type_free(&block_row);
+
+					for (r = 0; r < neighbour_rows; r++)
+					{
+						memcpy(&(array[neigbour_rstart + r][neigbour_cstart]),
+							&(block[(size_t) r*neighbour_cols]), neighbour_cols*sizeof(gol_cell));
+					}
 				}
 			}
 		}
+
+		free(block);
 	}
 	else
 	{
-		MPI_Send(&(myarray[row_start][col_start]), 1, block_array, 0, tag, virtual_comm);
+		MPI_Datatype block_array;
+		int my_coords[2];
+
+		MPI_Cart_coords(virtual_comm, my_rank, 2, my_coords);
+		int rows = row_cuts[my_coords[0] + 1] - row_cuts[my_coords[0]];
+		int cols = col_cuts[my_coords[1] + 1] - col_cuts[my_coords[1]];
+
+		//our block without the extra rows/cols
+		MPI_Type_vector(rows, cols, cols + 2, GOL_CELL_MPI, &block_array);
+		MPI_Type_commit(&block_array);
+		MPI_Send(&(myarray[1][1]), 1, block_array, 0, tag, virtual_comm);
+		MPI_Type_free(&block_array);
+	}
+}
+
+
+//Sum the changes of our rows (or cols) into the weights of the whole game's rows
+//and add the cost of computing them
+void activity_weights(long* weights, int n, int* changed, int offset, int local_n, long base, MPI_Comm virtual_comm)
+{
+	int i;
+
+	memset(weights, 0, n*sizeof(long));
+	for (i=0; i<local_n; i++)
+		weights[offset + i] = changed[i+1];
+
+	//the processes of the same row (col) of blocks add up the row's (col's) changes
+	MPI_Allreduce(MPI_IN_PLACE, weights, n, MPI_LONG, MPI_SUM, virtual_comm);
+
+	for (i=0; i<n; i++)
+		weights[i] = base + REPARTITION_ACTIVITY * weights[i];
+}
+
+
+//heaviest part of the cuts
+static long max_part_weight(long* weights, int parts, int* cuts)
+{
+	long max = 0;
+	int p, i;
+
+	for (p=0; p<parts; p++)
+	{
+		long weight = 0;
+		for (i=cuts[p]; i<cuts[p+1]; i++)
+			weight += weights[i];
+
+		if (weight > max)
+			max = weight;
+	}
+
+	return max;
+}
+
+
+//Split the rows [cuts[0], cuts[parts]) into parts of (about) equal weight, each with at least one row
+//Returns 1 if the new cuts are worth moving the blocks for
+int balance_cuts(long* weights, int parts, int* cuts, int* new_cuts)
+{
+	int first = cuts[0];
+	int last = cuts[parts];
+	long total = 0;
+	long prefix = 0;
+	int p, i;
+
+	for (i=first; i<last; i++)
+		total += weights[i];
+
+	new_cuts[0] = first;
+	new_cuts[parts] = last;
+	i = first;
+
+	for (p=1; p<parts; p++)
+	{
+		long target = total * p / parts;
+
+		//stop at the cut whose prefix is closest to the target
+		while (i < last && prefix + weights[i] <= target)
+			prefix += weights[i++];
+
+		if (i < last && (prefix + weights[i] - target) < (target - prefix))
+			prefix += weights[i++];
+
+		//leave at least one row to every part
+		if (i < new_cuts[p-1] + 1)
+		{
+			while (i < new_cuts[p-1] + 1)
+				prefix += weights[i++];
+		}
+		if (i > last - (parts - p))
+		{
+			while (i > last - (parts - p))
+				prefix -= weights[--i];
+		}
+
+		new_cuts[p] = i;
+	}
+
+	if (memcmp(cuts, new_cuts, (parts + 1)*sizeof(int)) == 0)
+		return 0;
+
+	if (max_part_weight(weights, parts, cuts) <= REPARTITION_TOLERANCE * max_part_weight(weights, parts, new_cuts))
+	{
+		memcpy(new_cuts, cuts, (parts + 1)*sizeof(int));
+		return 0;
+	}
+
+	return 1;
+}
+
+
+//Move the cells of the game from the old blocks to the new ones
+//Every process sends the part of its old block that lies in each new block (and receives the other way round)
+void gol_array_migrate(gol_array* old_ga, gol_array* new_ga, int* my_coords, int blocks_per_row, int blocks_per_col,
+	int* old_row_cuts, int* old_col_cuts, int* new_row_cuts, int* new_col_cuts, MPI_Comm virtual_comm)
+{
+	int tag = 301049;
+	int blocks = blocks_per_row * blocks_per_col;
+	MPI_Request* requests = malloc(2*blocks*sizeof(MPI_Request));
+	MPI_Datatype* types = malloc(2*blocks*sizeof(MPI_Datatype));
+	int n = 0;
+	int i, j, k, process;
+	int coords[2];
+	int sizes[2], subsizes[2], starts[2];
+
+	//our old and new block
+	int old_r0 = old_row_cuts[my_coords[0]], old_r1 = old_row_cuts[my_coords[0] + 1];
+	int old_c0 = old_col_cuts[my_coords[1]], old_c1 = old_col_cuts[my_coords[1] + 1];
+	int new_r0 = new_row_cuts[my_coords[0]], new_r1 = new_row_cuts[my_coords[0] + 1];
+	int new_c0 = new_col_cuts[my_coords[1]], new_c1 = new_col_cuts[my_coords[1] + 1];
+
+	for (i = 0; i < blocks_per_row; i++) {
+		for (j = 0; j < blocks_per_col; j++) {
+			coords[0] = i;
+			coords[1] = j;
+			MPI_Cart_rank(virtual_comm, coords, &process);
+
+			//receive what the old block (i,j) has of our new block
+			int r0 = (old_row_cuts[i] > new_r0) ? old_row_cuts[i] : new_r0;
+			int r1 = (old_row_cuts[i+1] < new_r1) ? old_row_cuts[i+1] : new_r1;
+			int c0 = (old_col_cuts[j] > new_c0) ? old_col_cuts[j] : new_c0;
+			int c1 = (old_col_cuts[j+1] < new_c1) ? old_col_cuts[j+1] : new_c1;
+
+			if (r0 < r1 && c0 < c1)
+			{
+				sizes[0] = new_ga->lines;
+				sizes[1] = new_ga->columns;
+				subsizes[0] = r1 - r0;
+				subsizes[1] = c1 - c0;
+				starts[0] = r0 - new_r0 + 1; //+1 due to extra row,col kept
+				starts[1] = c0 - new_c0 + 1;
+				MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, GOL_CELL_MPI, &types[n]);
+				MPI_Type_commit(&types[n]);
+				MPI_Irecv(new_ga->flat_array, 1, types[n], process, tag, virtual_comm, &requests[n]);
+				n++;
+			}
+
+			//send what our old block has of the new block (i,j)
+			r0 = (new_row_cuts[i] > old_r0) ? new_row_cuts[i] : old_r0;
+			r1 = (new_row_cuts[i+1] < old_r1) ? new_row_cuts[i+1] : old_r1;
+			c0 = (new_col_cuts[j] > old_c0) ? new_col_cuts[j] : old_c0;
+			c1 = (new_col_cuts[j+1] < old_c1) ? new_col_cuts[j+1] : old_c1;
+
+			if (r0 < r1 && c0 < c1)
+			{
+				sizes[0] = old_ga->lines;
+				sizes[1] = old_ga->columns;
+				subsizes[0] = r1 - r0;
+				subsizes[1] = c1 - c0;
+				starts[0] = r0 - old_r0 + 1;
+				starts[1] = c0 - old_c0 + 1;
+				MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, GOL_CELL_MPI, &types[n]);
+				MPI_Type_commit(&types[n]);
+				MPI_Isend(old_ga->flat_array, 1, types[n], process, tag, virtual_comm, &requests[n]);
+				n++;
+			}
+		}
+	}
+
+	MPI_Waitall(n, requests, MPI_STATUSES_IGNORE);
+
+	for (k=0; k<n; k++)
+		MPI_Type_free(&types[k]);
+
+	free(requests);
+	free(types);
+}
+
+
+//the block (row or col of blocks) that has row (or col) x
+int block_of(int x, int* cuts, int blocks)
+{
+	int low = 0, high = blocks - 1;
+
+	while (low < high)
+	{
+		int mid = (low + high + 1) / 2;
+
+		if (cuts[mid] <= x)
+			low = mid;
+		else
+			high = mid - 1;
+	}
+
+	return low;
+}
+
+
+//Index (row major) of the block this process (of game_comm) should own, so that the processes of a node own
+//a compact rectangle of tile_rows x tile_cols blocks and only its perimeter crosses the network.
+//Nodes must have the same number of processes, and their rectangles must tile the grid,
+//otherwise we keep the rank order (tile_rows and tile_cols are set to 0).
+int node_block_index(MPI_Comm game_comm, int blocks_per_row, int blocks_per_col, int* tile_rows, int* tile_cols)
+{
+	MPI_Comm node_comm, leader_comm;
+	int game_rank, processors, node_rank, node_size, node, min_size, max_size;
+	int a, b;
+
+	MPI_Comm_rank(game_comm, &game_rank);
+	MPI_Comm_size(game_comm, &processors);
+
+#if RANKS_PER_NODE > 0
+	MPI_Comm_split(game_comm, game_rank / RANKS_PER_NODE, game_rank, &node_comm);
+#else
+	MPI_Comm_split_type(game_comm, MPI_COMM_TYPE_SHARED, game_rank, MPI_INFO_NULL, &node_comm);
+#endif
+
+	MPI_Comm_rank(node_comm, &node_rank);
+	MPI_Comm_size(node_comm, &node_size);
+
+	//nodes are numbered by the rank of their first process
+	MPI_Comm_split(game_comm, (node_rank == 0) ? 0 : MPI_UNDEFINED, game_rank, &leader_comm);
+
+	if (node_rank == 0)
+	{
+		MPI_Comm_rank(leader_comm, &node);
+		MPI_Comm_free(&leader_comm);
+	}
+
+	MPI_Bcast(&node, 1, MPI_INT, 0, node_comm);
+	MPI_Comm_free(&node_comm);
+
+	MPI_Allreduce(&node_size, &min_size, 1, MPI_INT, MPI_MIN, game_comm);
+	MPI_Allreduce(&node_size, &max_size, 1, MPI_INT, MPI_MAX, game_comm);
+
+	*tile_rows = 0;
+	*tile_cols = 0;
+
+	if (min_size != max_size || blocks_per_row * blocks_per_col != processors)
+		return game_rank;
+
+	//the rectangle with the shortest perimeter that tiles the grid
+	for (a=1; a<=node_size; a++)
+	{
+		b = node_size / a;
+
+		if (node_size % a != 0 || blocks_per_row % a != 0 || blocks_per_col % b != 0)
+			continue;
+
+		if (*tile_rows == 0 || a + b < *tile_rows + *tile_cols)
+		{
+			*tile_rows = a;
+			*tile_cols = b;
+		}
+	}
+
+	if (*tile_rows == 0)
+		return game_rank;
+
+	//our node's rectangle, then our block in it
+	int tiles_per_col = blocks_per_col / *tile_cols;
+	int row = (node / tiles_per_col) * *tile_rows + node_rank / *tile_cols;
+	int col = (node % tiles_per_col) * *tile_cols + node_rank % *tile_cols;
+
+	return row * blocks_per_col + col;
+}
+
+
+//Ensemble mode: MPI_COMM_WORLD is split into groups of group_size processes, and each group plays
+//the games of the jobs file one after the other. A group takes the next job from a counter on
+//process 0 (MPI_Fetch_and_op), so groups that finish early keep taking jobs until there are none.
+//Each line of the jobs file is '<input file> <N> <M>' or 'random <N> <M> <seed>'
+void play_ensemble(char* jobs_file, int group_size, int max_loops, int reduce_rate,
+	int exchange_type, int repartition_rate, int max_skew, int progress)
+{
+	int world_rank, group_rank, groups, processors;
+	int jobs = 0;
+	int job, n_jobs_space = 16;
+	char line[320];
+	char (*job_files)[256] = malloc(n_jobs_space*sizeof(*job_files));
+	int* job_N = malloc(n_jobs_space*sizeof(int));
+	int* job_M = malloc(n_jobs_space*sizeof(int));
+	unsigned int* job_seeds = malloc(n_jobs_space*sizeof(unsigned int));
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &processors);
+
+	//every process reads the (small) jobs file
+	FILE* file = fopen(jobs_file, "r");
+
+	if (file == NULL)
+	{
+		printf("Error opening jobs file\n");
+		MPI_Abort(MPI_COMM_WORLD, -1);
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		if (strlen(line) == 0 || line[0] == '#' || line[0] == '\n')
+			continue;
+
+		if (jobs == n_jobs_space)
+		{
+			n_jobs_space *= 2;
+			job_files = realloc(job_files, n_jobs_space*sizeof(*job_files));
+			job_N = realloc(job_N, n_jobs_space*sizeof(int));
+			job_M = realloc(job_M, n_jobs_space*sizeof(int));
+			job_seeds = realloc(job_seeds, n_jobs_space*sizeof(unsigned int));
+		}
+
+		job_seeds[jobs] = time(NULL);
+
+		if (sscanf(line, "%255s %d %d %u", job_files[jobs], &job_N[jobs], &job_M[jobs], &job_seeds[jobs]) < 3)
+		{
+			if (world_rank == 0)
+				printf("Skipping invalid job line: '%s'\n", line);
+			continue;
+		}
+
+		jobs++;
+	}
+
+	fclose(file);
+
+	if (group_size < 1 || group_size > processors)
+		group_size = processors;
+
+	//(the last group gets the processes that are left, if they do not divide evenly)
+	MPI_Comm group_comm;
+	MPI_Comm_split(MPI_COMM_WORLD, world_rank / group_size, world_rank, &group_comm);
+	MPI_Comm_rank(group_comm, &group_rank);
+	groups = (processors + group_size - 1) / group_size;
+
+	if (INFO && world_rank == 0)
+		printf("Ensemble of %d jobs on %d groups of %d processes\n", jobs, groups, group_size);
+
+	//the job counter
+	int* counter;
+	int one = 1;
+	MPI_Win win;
+
+	MPI_Win_allocate((world_rank == 0) ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &counter, &win);
+	if (world_rank == 0)
+		*counter = 0;
+	MPI_Barrier(MPI_COMM_WORLD);
+	MPI_Win_lock_all(0, win);
+
+	while (1)
+	{
+		if (group_rank == 0)
+		{
+			MPI_Fetch_and_op(&one, &job, MPI_INT, 0, 0, MPI_SUM, win);
+			MPI_Win_flush(0, win);
+		}
+
+		MPI_Bcast(&job, 1, MPI_INT, 0, group_comm);
+
+		if (job >= jobs)
+			break;
+
+		char* filename = strcmp(job_files[job], "random") ? job_files[job] : NULL;
+		double elapsed;
+		int stopped_at;
+
+		play_game(group_comm, 1, &filename, &job_seeds[job], job_N[job], job_M[job], max_loops, reduce_rate,
+			exchange_type, repartition_rate, max_skew, progress, &stopped_at, &elapsed);
+
+		//one line per job
+		if (group_rank == 0)
+		{
+			if (stopped_at == -1)
+				printf("Job %d (%s %dx%d) on group %d: max loops (%d) reached, %f seconds\n",
+					job, job_files[job], job_N[job], job_M[job], world_rank / group_size, max_loops, elapsed);
+			else
+				printf("Job %d (%s %dx%d) on group %d: no change at loop %d, %f seconds\n",
+					job, job_files[job], job_N[job], job_M[job], world_rank / group_size, stopped_at, elapsed);
+			fflush(stdout);
+		}
+	}
+
+	MPI_Win_unlock_all(win);
+	MPI_Win_free(&win);
+	MPI_Comm_free(&group_comm);
+
+	free(job_files);
+	free(job_N);
+	free(job_M);
+	free(job_seeds);
+}
+
+
+//Batch mode: play every case of the manifest (all of them NxM) on the same blocks, datatypes and
+//persistent requests, only the cells are reset between cases.
+//Each line of the manifest is '<input file>' or 'random <seed>'
+void play_batch(char* manifest, int N, int M, int max_loops, int reduce_rate,
+	int exchange_type, int repartition_rate, int max_skew, int progress)
+{
+	int my_rank;
+	int cases = 0;
+	int c, n_cases_space = 16;
+	char line[320];
+	char (*case_names)[256] = malloc(n_cases_space*sizeof(*case_names));
+	unsigned int* seeds = malloc(n_cases_space*sizeof(unsigned int));
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+	//every process reads the (small) manifest, only the master reads the inputs
+	FILE* file = fopen(manifest, "r");
+
+	if (file == NULL)
+	{
+		printf("Error opening manifest\n");
+		MPI_Abort(MPI_COMM_WORLD, -1);
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		if (strlen(line) == 0 || line[0] == '#' || line[0] == '\n')
+			continue;
+
+		if (cases == n_cases_space)
+		{
+			n_cases_space *= 2;
+			case_names = realloc(case_names, n_cases_space*sizeof(*case_names));
+			seeds = realloc(seeds, n_cases_space*sizeof(unsigned int));
+		}
+
+		seeds[cases] = time(NULL);
+
+		if (sscanf(line, "%255s %u", case_names[cases], &seeds[cases]) < 1)
+			continue;
+
+		cases++;
+	}
+
+	fclose(file);
+
+	char** filenames = malloc(cases*sizeof(char*));
+	int* stopped_at = malloc(cases*sizeof(int));
+	double* elapsed_times = malloc(cases*sizeof(double));
+
+	for (c=0; c<cases; c++)
+		filenames[c] = strcmp(case_names[c], "random") ? case_names[c] : NULL;
+
+	play_game(MPI_COMM_WORLD, cases, filenames, seeds, N, M, max_loops, reduce_rate,
+		exchange_type, repartition_rate, max_skew, progress, stopped_at, elapsed_times);
+
+	//one line per case
+	if (my_rank == 0)
+	{
+		for (c=0; c<cases; c++)
+		{
+			if (stopped_at[c] == -1)
+				printf("Case %d (%s): max loops (%d) reached, %f seconds\n", c, case_names[c], max_loops, elapsed_times[c]);
+			else
+				printf("Case %d (%s): no change at loop %d, %f seconds\n", c, case_names[c], stopped_at[c], elapsed_times[c]);
+		}
 	}
 
-  gol_array_free(&block_gol_array);
+	free(case_names);
+	free(seeds);
+	free(filenames);
+	free(stopped_at);
+	free(elapsed_times);
 }
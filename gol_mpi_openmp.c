@@ -10,6 +10,7 @@
 
 #include "./gol_lib/gol_array.h"
 #include "./gol_lib/functions.h"
+#include "./gol_lib/tile_scheduler.h"
 
 #define DEBUG 0
 #define INFO 1
@@ -23,14 +24,21 @@
 #define MAX_LOOPS 200
 #define REDUCE_RATE 1
 #define NUM_THREADS 2
+#define COMM_THREAD 0 //1 to let the master thread only do MPI until the halos arrive (-d)
+#define TILE_ROWS 4 //rows of an inner tile, when tiles are handed out to the threads one by one
+#define BORDER_STRIPS 8 //up, down, left, right edge (without the corners), then the 4 corners, as the receives
+#define PARTITIONED 0 //1 to send the up/down edges in partitions, each one marked ready by its thread (MPI-4, -p)
 #define SAVE_GENERATED 0
   
 void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int processors, int lines, int columns,
 										int rows_per_block, int cols_per_block, int blocks_per_row, MPI_Comm virtual_comm);
 void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines, int columns,
 										int rows_per_block, int cols_per_block, int blocks_per_row, MPI_Comm virtual_comm);
-void gol_array_gather(short int** array, short int** myarray, int my_rank, int processes, int row_start, int col_start, 
+void gol_array_gather(gol_cell** array, gol_cell** myarray, int my_rank, int processes, int row_start, int col_start, 
 	int blocks_per_row, int blocks_per_col, int rows_per_block, int cols_per_block, MPI_Datatype block_array, MPI_Comm virtual_comm);
+int populate_block(gol_grid grid1, gol_grid grid2, int row_first, int row_last, int col_first, int col_last);
+int populate_border_strip(gol_grid grid1, gol_grid grid2, int strip,
+	int row_start, int row_end, int col_start, int col_end);
 
 int main(int argc, char* argv[])
 {
@@ -52,15 +60,31 @@ int main(int argc, char* argv[])
 	//MPI init
 	int my_rank, processors;
   int openmp_threads = NUM_THREADS;
+	int comm_thread = COMM_THREAD;
+	int partitioned = PARTITIONED;
 	int tag = 201049;
 	MPI_Status status;
 	int coordinates[2];
 	char* filename = NULL;
 
-	MPI_Init (&argc, &argv);
+	//only the master thread of the parallel region calls MPI,
+	//except for the partitioned sends that every thread marks ready (MPI_THREAD_MULTIPLE)
+	for (i = 1; i < argc - 1; i++)
+		if ( !strcmp(argv[i], "-p") )
+			partitioned = atoi(argv[i+1]);
+
+	int thread_support;
+	int thread_level = partitioned ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED;
+	MPI_Init_thread (&argc, &argv, thread_level, &thread_support);
 	MPI_Comm_size(MPI_COMM_WORLD, &processors);
 	MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
 
+	if (thread_support < thread_level && my_rank == 0)
+		printf("Warning, the MPI library does not support the %s thread level\n",
+			partitioned ? "MPI_THREAD_MULTIPLE" : "MPI_THREAD_FUNNELED");
+	if (partitioned && thread_support < MPI_THREAD_MULTIPLE)
+		partitioned = 0;
+
 	N = -1;
 	M = -1;
 
@@ -99,6 +123,15 @@ int main(int argc, char* argv[])
       openmp_threads = atoi(argv[i+1]);
       i++;
     }
+		else if ( !strcmp(argv[i], "-d") )
+		{
+			comm_thread = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-p") )
+		{
+			i++; //read before MPI_Init
+		}
 	}
 
   omp_set_num_threads(openmp_threads);
@@ -208,7 +241,7 @@ int main(int argc, char* argv[])
 	MPI_Type_vector(rows_per_block,    
 	   1,                  
 	   cols_per_block + 2,         
-	   MPI_SHORT,       
+	   GOL_CELL_MPI,       
 	   &derived_type_block_col);       
 
 	MPI_Type_commit(&derived_type_block_col);
@@ -220,7 +253,7 @@ int main(int argc, char* argv[])
 	MPI_Type_vector(rows_per_block,    
 	   cols_per_block,                  
 	   cols_per_block + 2,         
-	   MPI_SHORT,       
+	   GOL_CELL_MPI,       
 	   &derived_type_block_array);       
 
 	MPI_Type_commit(&derived_type_block_array);
@@ -244,7 +277,7 @@ int main(int argc, char* argv[])
   	periods[1] = 1;
   	reorder = 1;
 
-  	int ret = MPI_Cart_create(MPI_COMM_WORLD, ndimansions, dimansion_size, periods, reorder, &virtual_comm);
+  	MPI_Cart_create(MPI_COMM_WORLD, ndimansions, dimansion_size, periods, reorder, &virtual_comm);
   	MPI_Comm_rank(virtual_comm, &my_rank); //rank might have changed due to reorder
 
   	//find neighbour processes ranks
@@ -253,7 +286,7 @@ int main(int argc, char* argv[])
   	int neighbour_coords[2];
   	int my_coords[2];
 
-  	if (ret == MPI_COMM_NULL) 
+  	if (virtual_comm == MPI_COMM_NULL) 
   	{
   		printf("Process %d wont be included in this game of life.\n", my_rank);
   		printf("The grid is smaller than available processes!\n");
@@ -263,40 +296,40 @@ int main(int argc, char* argv[])
   	else //get this process's rank and coords
   	{
   		//get this process's coordinates in the virtual topology
-  		ret = MPI_Cart_coords(virtual_comm, my_rank, ndimansions, my_coords);
+  		MPI_Cart_coords(virtual_comm, my_rank, ndimansions, my_coords);
 
   		//get the ranks of this process's (8) neighbours
   		neighbour_coords[0] = my_coords[0] - 1;
   		neighbour_coords[1] = my_coords[1];
-  		ret = MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_u);
+  		MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_u);
 
   		neighbour_coords[0] = my_coords[0] + 1;
   		neighbour_coords[1] = my_coords[1];
-  		ret = MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_d);
+  		MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_d);
 
   		neighbour_coords[0] = my_coords[0];
   		neighbour_coords[1] = my_coords[1] + 1;
-  		ret = MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_r);
+  		MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_r);
 
   		neighbour_coords[0] = my_coords[0];
   		neighbour_coords[1] = my_coords[1] - 1;
-  		ret = MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_l);
+  		MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_l);
 
   		neighbour_coords[0] = my_coords[0] - 1;
   		neighbour_coords[1] = my_coords[1] + 1;
-  		ret = MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_ur);
+  		MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_ur);
 
   		neighbour_coords[0] = my_coords[0] - 1;
   		neighbour_coords[1] = my_coords[1] - 1;
-  		ret = MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_ul);
+  		MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_ul);
 
   		neighbour_coords[0] = my_coords[0] + 1;
   		neighbour_coords[1] = my_coords[1] + 1;
-  		ret = MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_dr);
+  		MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_dr);
 
   		neighbour_coords[0] = my_coords[0] + 1;
   		neighbour_coords[1] = my_coords[1] - 1;
-  		ret = MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_dl);
+  		MPI_Cart_rank(virtual_comm, neighbour_coords, &rank_dl);
 
   		if (DEBUG)
 	  	{
@@ -339,7 +372,7 @@ int main(int argc, char* argv[])
 
 				  	neighbour_coords[0] = i;
 				  	neighbour_coords[1] = j;
-				  	ret = MPI_Cart_rank(virtual_comm, neighbour_coords, &proccess_rank);
+				  	MPI_Cart_rank(virtual_comm, neighbour_coords, &proccess_rank);
 			
 					printf("%d: rows [%d-%d] cols [%d-%d]\n", proccess_rank, row_start, row_end, col_start, col_end);
 	  			}
@@ -373,7 +406,7 @@ int main(int argc, char* argv[])
   	else //for other processes besides master
   	{
   		//receive coordinates of alive cells, until we receive (-1,-1)
-  		short int** array = ga1->array;
+  		gol_cell** array = ga1->array;
   		int finished = 0;
 
   		while (!finished)
@@ -433,8 +466,7 @@ int main(int argc, char* argv[])
 			x8 MPI_ISend (MPI_Start)
 			x8 MPI_IRecv (MPI_Start)
 			Calculate 'inner' cells
-			Wait for IRecvs to complete
-			Calculate 'outer' cells
+			Calculate 'outer' cells, a strip as soon as the IRecvs it needs complete (MPI_Waitany)
 			MPI_Allreduce for master to see if there was a change or not
 			If (change && repeats < max_repeats)
 				repeat
@@ -444,8 +476,11 @@ int main(int argc, char* argv[])
 	*/
 
 	//Define communication (requests) that will be made in each loop with MPI_Init
-	short int** array1 = ga1->array;
-	short int** array2 = ga2->array;
+	gol_cell** array1 = ga1->array;
+	gol_cell** array2 = ga2->array;
+	//the same arrays without the row pointer table, for the compute kernels (swapped along with them)
+	gol_grid grid1 = gol_array_block_grid(ga1, N, M);
+	gol_grid grid2 = gol_array_block_grid(ga2, N, M);
 	
 	//We need to define two types of requests
 	//Because the send/receive buffer is changed due to swapping after each loop/generation
@@ -477,16 +512,16 @@ int main(int argc, char* argv[])
 	MPI_Request send_request[2][8];
 	//rows
 	if (line_div != 1) {
-		MPI_Send_init( &array1[row_start][col_start], cols_per_block, MPI_SHORT, rank_u, send_tags[0], virtual_comm, &send_request[0][0]);
-		MPI_Send_init( &array1[row_end][col_start],   cols_per_block, MPI_SHORT, rank_d, send_tags[1], virtual_comm, &send_request[0][1]);
-		MPI_Send_init( &array2[row_start][col_start], cols_per_block, MPI_SHORT, rank_u, send_tags[0], virtual_comm, &send_request[1][0]);
-		MPI_Send_init( &array2[row_end][col_start],   cols_per_block, MPI_SHORT, rank_d, send_tags[1], virtual_comm, &send_request[1][1]);
+		MPI_Send_init( &array1[row_start][col_start], cols_per_block, GOL_CELL_MPI, rank_u, send_tags[0], virtual_comm, &send_request[0][0]);
+		MPI_Send_init( &array1[row_end][col_start],   cols_per_block, GOL_CELL_MPI, rank_d, send_tags[1], virtual_comm, &send_request[0][1]);
+		MPI_Send_init( &array2[row_start][col_start], cols_per_block, GOL_CELL_MPI, rank_u, send_tags[0], virtual_comm, &send_request[1][0]);
+		MPI_Send_init( &array2[row_end][col_start],   cols_per_block, GOL_CELL_MPI, rank_d, send_tags[1], virtual_comm, &send_request[1][1]);
 	}
 	else { //process has all the rows it needs
-		MPI_Send_init( &array1[row_start][col_start], cols_per_block, MPI_SHORT, MPI_PROC_NULL, send_tags[0], virtual_comm, &send_request[0][0]);
-		MPI_Send_init( &array1[row_end][col_start],   cols_per_block, MPI_SHORT, MPI_PROC_NULL, send_tags[1], virtual_comm, &send_request[0][1]);
-		MPI_Send_init( &array2[row_start][col_start], cols_per_block, MPI_SHORT, MPI_PROC_NULL, send_tags[0], virtual_comm, &send_request[1][0]);
-		MPI_Send_init( &array2[row_end][col_start],   cols_per_block, MPI_SHORT, MPI_PROC_NULL, send_tags[1], virtual_comm, &send_request[1][1]);
+		MPI_Send_init( &array1[row_start][col_start], cols_per_block, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[0], virtual_comm, &send_request[0][0]);
+		MPI_Send_init( &array1[row_end][col_start],   cols_per_block, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[1], virtual_comm, &send_request[0][1]);
+		MPI_Send_init( &array2[row_start][col_start], cols_per_block, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[0], virtual_comm, &send_request[1][0]);
+		MPI_Send_init( &array2[row_end][col_start],   cols_per_block, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[1], virtual_comm, &send_request[1][1]);
 	}
 	//cols
 	if (col_div != 1) {
@@ -503,24 +538,24 @@ int main(int argc, char* argv[])
 	}
 	//corners
 	if (line_div != 1 || col_div != 1) {
-		MPI_Send_init( &array1[row_start][col_start], 1, MPI_SHORT, rank_ul, send_tags[4], virtual_comm, &send_request[0][4]);
-		MPI_Send_init( &array1[row_start][col_end],   1, MPI_SHORT, rank_ur, send_tags[5], virtual_comm, &send_request[0][5]);
-		MPI_Send_init( &array1[row_end][col_start],   1, MPI_SHORT, rank_dl, send_tags[6], virtual_comm, &send_request[0][6]);
-		MPI_Send_init( &array1[row_end][col_end],     1, MPI_SHORT, rank_dr, send_tags[7], virtual_comm, &send_request[0][7]);
-		MPI_Send_init( &array2[row_start][col_start], 1, MPI_SHORT, rank_ul, send_tags[4], virtual_comm, &send_request[1][4]);
-		MPI_Send_init( &array2[row_start][col_end],   1, MPI_SHORT, rank_ur, send_tags[5], virtual_comm, &send_request[1][5]);
-		MPI_Send_init( &array2[row_end][col_start],   1, MPI_SHORT, rank_dl, send_tags[6], virtual_comm, &send_request[1][6]);
-		MPI_Send_init( &array2[row_end][col_end],     1, MPI_SHORT, rank_dr, send_tags[7], virtual_comm, &send_request[1][7]);
+		MPI_Send_init( &array1[row_start][col_start], 1, GOL_CELL_MPI, rank_ul, send_tags[4], virtual_comm, &send_request[0][4]);
+		MPI_Send_init( &array1[row_start][col_end],   1, GOL_CELL_MPI, rank_ur, send_tags[5], virtual_comm, &send_request[0][5]);
+		MPI_Send_init( &array1[row_end][col_start],   1, GOL_CELL_MPI, rank_dl, send_tags[6], virtual_comm, &send_request[0][6]);
+		MPI_Send_init( &array1[row_end][col_end],     1, GOL_CELL_MPI, rank_dr, send_tags[7], virtual_comm, &send_request[0][7]);
+		MPI_Send_init( &array2[row_start][col_start], 1, GOL_CELL_MPI, rank_ul, send_tags[4], virtual_comm, &send_request[1][4]);
+		MPI_Send_init( &array2[row_start][col_end],   1, GOL_CELL_MPI, rank_ur, send_tags[5], virtual_comm, &send_request[1][5]);
+		MPI_Send_init( &array2[row_end][col_start],   1, GOL_CELL_MPI, rank_dl, send_tags[6], virtual_comm, &send_request[1][6]);
+		MPI_Send_init( &array2[row_end][col_end],     1, GOL_CELL_MPI, rank_dr, send_tags[7], virtual_comm, &send_request[1][7]);
 	}
 	else {
-		MPI_Send_init( &array1[row_start][col_start], 1, MPI_SHORT, MPI_PROC_NULL, send_tags[4], virtual_comm, &send_request[0][4]);
-		MPI_Send_init( &array1[row_start][col_end],   1, MPI_SHORT, MPI_PROC_NULL, send_tags[5], virtual_comm, &send_request[0][5]);
-		MPI_Send_init( &array1[row_end][col_start],   1, MPI_SHORT, MPI_PROC_NULL, send_tags[6], virtual_comm, &send_request[0][6]);
-		MPI_Send_init( &array1[row_end][col_end],     1, MPI_SHORT, MPI_PROC_NULL, send_tags[7], virtual_comm, &send_request[0][7]);
-		MPI_Send_init( &array2[row_start][col_start], 1, MPI_SHORT, MPI_PROC_NULL, send_tags[4], virtual_comm, &send_request[1][4]);
-		MPI_Send_init( &array2[row_start][col_end],   1, MPI_SHORT, MPI_PROC_NULL, send_tags[5], virtual_comm, &send_request[1][5]);
-		MPI_Send_init( &array2[row_end][col_start],   1, MPI_SHORT, MPI_PROC_NULL, send_tags[6], virtual_comm, &send_request[1][6]);
-		MPI_Send_init( &array2[row_end][col_end],     1, MPI_SHORT, MPI_PROC_NULL, send_tags[7], virtual_comm, &send_request[1][7]);
+		MPI_Send_init( &array1[row_start][col_start], 1, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[4], virtual_comm, &send_request[0][4]);
+		MPI_Send_init( &array1[row_start][col_end],   1, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[5], virtual_comm, &send_request[0][5]);
+		MPI_Send_init( &array1[row_end][col_start],   1, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[6], virtual_comm, &send_request[0][6]);
+		MPI_Send_init( &array1[row_end][col_end],     1, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[7], virtual_comm, &send_request[0][7]);
+		MPI_Send_init( &array2[row_start][col_start], 1, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[4], virtual_comm, &send_request[1][4]);
+		MPI_Send_init( &array2[row_start][col_end],   1, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[5], virtual_comm, &send_request[1][5]);
+		MPI_Send_init( &array2[row_end][col_start],   1, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[6], virtual_comm, &send_request[1][6]);
+		MPI_Send_init( &array2[row_end][col_end],     1, GOL_CELL_MPI, MPI_PROC_NULL, send_tags[7], virtual_comm, &send_request[1][7]);
 	}
 
 	//then the receive requests
@@ -532,16 +567,16 @@ int main(int argc, char* argv[])
 
 	//rows
 	if (line_div != 1) {
-		MPI_Recv_init( &array1[up_row][col_start],   cols_per_block, MPI_SHORT, rank_u, receive_tags[0], virtual_comm, &recv_request[0][0]);
-		MPI_Recv_init( &array1[down_row][col_start], cols_per_block, MPI_SHORT, rank_d, receive_tags[1], virtual_comm, &recv_request[0][1]);
-		MPI_Recv_init( &array2[up_row][col_start],   cols_per_block, MPI_SHORT, rank_u, receive_tags[0], virtual_comm, &recv_request[1][0]);
-		MPI_Recv_init( &array2[down_row][col_start], cols_per_block, MPI_SHORT, rank_d, receive_tags[1], virtual_comm, &recv_request[1][1]);
+		MPI_Recv_init( &array1[up_row][col_start],   cols_per_block, GOL_CELL_MPI, rank_u, receive_tags[0], virtual_comm, &recv_request[0][0]);
+		MPI_Recv_init( &array1[down_row][col_start], cols_per_block, GOL_CELL_MPI, rank_d, receive_tags[1], virtual_comm, &recv_request[0][1]);
+		MPI_Recv_init( &array2[up_row][col_start],   cols_per_block, GOL_CELL_MPI, rank_u, receive_tags[0], virtual_comm, &recv_request[1][0]);
+		MPI_Recv_init( &array2[down_row][col_start], cols_per_block, GOL_CELL_MPI, rank_d, receive_tags[1], virtual_comm, &recv_request[1][1]);
 	}
 	else {
-		MPI_Recv_init( &array1[up_row][col_start],   cols_per_block, MPI_SHORT, MPI_PROC_NULL, receive_tags[0], virtual_comm, &recv_request[0][0]);
-		MPI_Recv_init( &array1[down_row][col_start], cols_per_block, MPI_SHORT, MPI_PROC_NULL, receive_tags[1], virtual_comm, &recv_request[0][1]);
-		MPI_Recv_init( &array2[up_row][col_start],   cols_per_block, MPI_SHORT, MPI_PROC_NULL, receive_tags[0], virtual_comm, &recv_request[1][0]);
-		MPI_Recv_init( &array2[down_row][col_start], cols_per_block, MPI_SHORT, MPI_PROC_NULL, receive_tags[1], virtual_comm, &recv_request[1][1]);
+		MPI_Recv_init( &array1[up_row][col_start],   cols_per_block, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[0], virtual_comm, &recv_request[0][0]);
+		MPI_Recv_init( &array1[down_row][col_start], cols_per_block, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[1], virtual_comm, &recv_request[0][1]);
+		MPI_Recv_init( &array2[up_row][col_start],   cols_per_block, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[0], virtual_comm, &recv_request[1][0]);
+		MPI_Recv_init( &array2[down_row][col_start], cols_per_block, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[1], virtual_comm, &recv_request[1][1]);
 	}
 	//cols
 	if (col_div != 1) {
@@ -558,25 +593,75 @@ int main(int argc, char* argv[])
 	}
 	//corners
 	if (line_div != 1 || col_div != 1) {
-		MPI_Recv_init( &array1[up_row][left_col],  1, MPI_SHORT, rank_ul, receive_tags[4], virtual_comm, &recv_request[0][4]);
-		MPI_Recv_init( &array1[up_row][right_col], 1, MPI_SHORT, rank_ur, receive_tags[5], virtual_comm, &recv_request[0][5]);
-		MPI_Recv_init( &array1[down_row][left_col],  1, MPI_SHORT, rank_dl, receive_tags[6], virtual_comm, &recv_request[0][6]);
-		MPI_Recv_init( &array1[down_row][right_col], 1, MPI_SHORT, rank_dr, receive_tags[7], virtual_comm, &recv_request[0][7]);
-		MPI_Recv_init( &array2[up_row][left_col],  1, MPI_SHORT, rank_ul, receive_tags[4], virtual_comm, &recv_request[1][4]);
-		MPI_Recv_init( &array2[up_row][right_col], 1, MPI_SHORT, rank_ur, receive_tags[5], virtual_comm, &recv_request[1][5]);
-		MPI_Recv_init( &array2[down_row][left_col],  1, MPI_SHORT, rank_dl, receive_tags[6], virtual_comm, &recv_request[1][6]);
-		MPI_Recv_init( &array2[down_row][right_col], 1, MPI_SHORT, rank_dr, receive_tags[7], virtual_comm, &recv_request[1][7]);
+		MPI_Recv_init( &array1[up_row][left_col],  1, GOL_CELL_MPI, rank_ul, receive_tags[4], virtual_comm, &recv_request[0][4]);
+		MPI_Recv_init( &array1[up_row][right_col], 1, GOL_CELL_MPI, rank_ur, receive_tags[5], virtual_comm, &recv_request[0][5]);
+		MPI_Recv_init( &array1[down_row][left_col],  1, GOL_CELL_MPI, rank_dl, receive_tags[6], virtual_comm, &recv_request[0][6]);
+		MPI_Recv_init( &array1[down_row][right_col], 1, GOL_CELL_MPI, rank_dr, receive_tags[7], virtual_comm, &recv_request[0][7]);
+		MPI_Recv_init( &array2[up_row][left_col],  1, GOL_CELL_MPI, rank_ul, receive_tags[4], virtual_comm, &recv_request[1][4]);
+		MPI_Recv_init( &array2[up_row][right_col], 1, GOL_CELL_MPI, rank_ur, receive_tags[5], virtual_comm, &recv_request[1][5]);
+		MPI_Recv_init( &array2[down_row][left_col],  1, GOL_CELL_MPI, rank_dl, receive_tags[6], virtual_comm, &recv_request[1][6]);
+		MPI_Recv_init( &array2[down_row][right_col], 1, GOL_CELL_MPI, rank_dr, receive_tags[7], virtual_comm, &recv_request[1][7]);
 	}
 	else {
-		MPI_Recv_init( &array1[up_row][left_col],  1, MPI_SHORT, MPI_PROC_NULL, receive_tags[4], virtual_comm, &recv_request[0][4]);
-		MPI_Recv_init( &array1[up_row][right_col], 1, MPI_SHORT, MPI_PROC_NULL, receive_tags[5], virtual_comm, &recv_request[0][5]);
-		MPI_Recv_init( &array1[down_row][left_col],  1, MPI_SHORT, MPI_PROC_NULL, receive_tags[6], virtual_comm, &recv_request[0][6]);
-		MPI_Recv_init( &array1[down_row][right_col], 1, MPI_SHORT, MPI_PROC_NULL, receive_tags[7], virtual_comm, &recv_request[0][7]);
-		MPI_Recv_init( &array2[up_row][left_col],  1, MPI_SHORT, MPI_PROC_NULL, receive_tags[4], virtual_comm, &recv_request[1][4]);
-		MPI_Recv_init( &array2[up_row][right_col], 1, MPI_SHORT, MPI_PROC_NULL, receive_tags[5], virtual_comm, &recv_request[1][5]);
-		MPI_Recv_init( &array2[down_row][left_col],  1, MPI_SHORT, MPI_PROC_NULL, receive_tags[6], virtual_comm, &recv_request[1][6]);
-		MPI_Recv_init( &array2[down_row][right_col], 1, MPI_SHORT, MPI_PROC_NULL, receive_tags[7], virtual_comm, &recv_request[1][7]);
+		MPI_Recv_init( &array1[up_row][left_col],  1, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[4], virtual_comm, &recv_request[0][4]);
+		MPI_Recv_init( &array1[up_row][right_col], 1, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[5], virtual_comm, &recv_request[0][5]);
+		MPI_Recv_init( &array1[down_row][left_col],  1, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[6], virtual_comm, &recv_request[0][6]);
+		MPI_Recv_init( &array1[down_row][right_col], 1, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[7], virtual_comm, &recv_request[0][7]);
+		MPI_Recv_init( &array2[up_row][left_col],  1, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[4], virtual_comm, &recv_request[1][4]);
+		MPI_Recv_init( &array2[up_row][right_col], 1, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[5], virtual_comm, &recv_request[1][5]);
+		MPI_Recv_init( &array2[down_row][left_col],  1, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[6], virtual_comm, &recv_request[1][6]);
+		MPI_Recv_init( &array2[down_row][right_col], 1, GOL_CELL_MPI, MPI_PROC_NULL, receive_tags[7], virtual_comm, &recv_request[1][7]);
+	}
+
+	//with partitioned sends, the up/down edges are split in 'partitions' equal parts
+	//They need MPI-4, a neighbour above and below us, and (for now) no communication thread
+	int partitions = 1;
+
+#if MPI_VERSION >= 4
+	int partition_cols = cols_per_block;
+
+	if (partitioned && (line_div == 1 || comm_thread))
+	{
+		if (my_rank == 0)
+			printf("Warning, partitioned sends need more than one block row and no communication thread\n");
+		partitioned = 0;
+	}
+
+	if (partitioned)
+	{
+		for (partitions = openmp_threads; cols_per_block % partitions != 0; partitions--);
+		partition_cols = cols_per_block / partitions;
+
+		if (INFO && my_rank == 0)
+			printf("Sending the up/down edges in %d partitions of %d cells\n", partitions, partition_cols);
+
+		//replace the up/down edge requests of both arrays
+		for (i = 0; i < 2; i++)
+		{
+			for (j = 0; j < 2; j++)
+			{
+				MPI_Request_free(&send_request[i][j]);
+				MPI_Request_free(&recv_request[i][j]);
+			}
+		}
+		MPI_Psend_init( &array1[row_start][col_start], partitions, partition_cols, GOL_CELL_MPI, rank_u, send_tags[0], virtual_comm, MPI_INFO_NULL, &send_request[0][0]);
+		MPI_Psend_init( &array1[row_end][col_start],   partitions, partition_cols, GOL_CELL_MPI, rank_d, send_tags[1], virtual_comm, MPI_INFO_NULL, &send_request[0][1]);
+		MPI_Psend_init( &array2[row_start][col_start], partitions, partition_cols, GOL_CELL_MPI, rank_u, send_tags[0], virtual_comm, MPI_INFO_NULL, &send_request[1][0]);
+		MPI_Psend_init( &array2[row_end][col_start],   partitions, partition_cols, GOL_CELL_MPI, rank_d, send_tags[1], virtual_comm, MPI_INFO_NULL, &send_request[1][1]);
+		MPI_Precv_init( &array1[up_row][col_start],   partitions, partition_cols, GOL_CELL_MPI, rank_u, receive_tags[0], virtual_comm, MPI_INFO_NULL, &recv_request[0][0]);
+		MPI_Precv_init( &array1[down_row][col_start], partitions, partition_cols, GOL_CELL_MPI, rank_d, receive_tags[1], virtual_comm, MPI_INFO_NULL, &recv_request[0][1]);
+		MPI_Precv_init( &array2[up_row][col_start],   partitions, partition_cols, GOL_CELL_MPI, rank_u, receive_tags[0], virtual_comm, MPI_INFO_NULL, &recv_request[1][0]);
+		MPI_Precv_init( &array2[down_row][col_start], partitions, partition_cols, GOL_CELL_MPI, rank_d, receive_tags[1], virtual_comm, MPI_INFO_NULL, &recv_request[1][1]);
 	}
+#else
+	if (partitioned && my_rank == 0)
+		printf("Warning, partitioned sends need an MPI-4 library, using persistent sends\n");
+	partitioned = 0;
+#endif
+
+	//the receives each up/down edge partition needs (as strip_needs, the first and last have a corner)
+	int* partition_needs = malloc(2 * partitions * sizeof(int));
+	char* partition_launched = malloc(2 * partitions);
 
 	int count;
 	int no_change;
@@ -593,7 +678,7 @@ int main(int argc, char* argv[])
 	if (PRINT_INITIAL)
 	{
     whole_array = gol_array_init(N, M);
-    short int** array = whole_array->array;
+    gol_cell** array = whole_array->array;
 		gol_array_gather(array, array1, my_rank, processors, row_start, col_start,
 			blocks_per_row, blocks_per_col, rows_per_block, cols_per_block, derived_type_block_array, virtual_comm);
 		if (my_rank == 0) {
@@ -615,135 +700,331 @@ int main(int argc, char* argv[])
 
 	start = MPI_Wtime();
 
-	for(count = 0; count < max_loops; count++) 
+	//one team for the whole game, the generations share it through worksharing loops
+	//MPI is only called by the master thread (MPI_THREAD_FUNNELED), the others wait at the barriers
+	//With a communication thread (-d 1) the master waits for the halos while the others take
+	//inner tiles, and everyone takes the border strips as soon as the halos are in
+	int terminate = 0;
+	int ready_strips, taken_strips;
+	tile_scheduler* ts = NULL;
+	int inner_tiles = (rows_per_block - 2 + TILE_ROWS - 1) / TILE_ROWS;
+	int all_strips = (1 << BORDER_STRIPS) - 1;
+
+	if (inner_tiles < 0)
+		inner_tiles = 0;
+
+	//the receives (bits) each border strip needs. An edge needs its own halo, a corner the
+	//halos of its two edges and its corner. A block one cell thin needs all of them everywhere
+	int strip_needs[BORDER_STRIPS];
+	for (i = 0; i < BORDER_STRIPS; i++)
+		strip_needs[i] = 1 << i;
+	strip_needs[4] |= (1 << 0) | (1 << 2); //up left : up, left
+	strip_needs[5] |= (1 << 0) | (1 << 3); //up right : up, right
+	strip_needs[6] |= (1 << 1) | (1 << 2); //down left : down, left
+	strip_needs[7] |= (1 << 1) | (1 << 3); //down right : down, right
+	for (i = 0; i < 2 * partitions; i++)
 	{
-		no_change = 1;
+		j = i % partitions;
+		partition_needs[i] = 1 << (i / partitions);
+		if (j == 0)
+			partition_needs[i] |= strip_needs[i < partitions ? 4 : 6];
+		if (j == partitions - 1)
+			partition_needs[i] |= strip_needs[i < partitions ? 5 : 7];
+	}
+	if (rows_per_block < 2 || cols_per_block < 2)
+	{
+		for (i = 0; i < BORDER_STRIPS; i++)
+			strip_needs[i] = all_strips;
+		for (i = 0; i < 2 * partitions; i++)
+			partition_needs[i] = all_strips;
+	}
 
-		//8 Isend
-		MPI_Startall(8, send_request[communication_type]);
-		//8 IRecv
-		MPI_Startall(8, recv_request[communication_type]);
+	//In a block one row (col) thin, the up and down (left and right) edges are the same cells, and so are the
+	//corners two by two: one strip of each pair is left out (as if already taken), so that no two threads write them
+	int duplicate_strips = 0;
+	if (rows_per_block < 2)
+		duplicate_strips |= (1 << 1) | (1 << 6) | (1 << 7); //down, down left, down right
+	if (cols_per_block < 2)
+		duplicate_strips |= (1 << 3) | (1 << 5) | (1 << 7); //right, up right, down right
+
+#if MPI_VERSION >= 4
+	//the first generation's edges are already there
+	if (partitioned)
+	{
+		MPI_Startall(2, send_request[0]);
+		MPI_Pready_range(0, partitions - 1, send_request[0][0]);
+		MPI_Pready_range(0, partitions - 1, send_request[0][1]);
+	}
+#endif
 
-		//calculate/populate 'inner' cells
-    #pragma omp parallel for collapse(2)
-		for (i=row_start + 1; i<= row_end - 1; i++) {
-			for (j= col_start + 1; j <= col_end - 1; j++) {
-				//for each cell/organism
+	if (INFO && my_rank == 0 && comm_thread)
+		printf("Using a communication thread, %d inner tiles of %d rows\n", inner_tiles, TILE_ROWS);
 
-				//for each cell/organism
-				//see if there is a change
-				//populate functions applies the game's rules
-				//and returns 0 if a change occurs
-				if (populate(array1, array2, N, M, i, j) == 0)
-					no_change = 0;	
-			}
-		}
+	#pragma omp parallel private(i)
+	{
+		int loop, tile;
 
-		//wait for recvs
-		MPI_Waitall(8, recv_request[communication_type], statuses);
+		//a deque of inner tiles per thread of the team (communication thread mode)
+		#pragma omp single
+		ts = tile_scheduler_init(omp_get_num_threads(), inner_tiles);
 
-		//calculate/populate 'outer' cells
-		
-		//up/down row
-    #pragma omp parallel for
-		for (j= col_start; j <= col_end; j++) {
-      #pragma omp parallel sections
-      {
-        #pragma omp section
-        {
-    			if (populate(array1, array2, N, M, row_start, j) == 0)
-    				no_change = 0;
-    		}
-        #pragma omp section
-        {
-        	if (populate(array1, array2, N, M, row_end, j) == 0)
-    				no_change = 0;
-        }
-      }
-		}
+		for (loop = 0; loop < max_loops; loop++)
+		{
+			//each thread starts with its band of inner tiles, and steals from the others when it is done
+			if (comm_thread)
+			{
+				tile_scheduler_reset(ts, omp_get_thread_num());
+				for (tile = tile_scheduler_band_start(ts, omp_get_thread_num()); tile < tile_scheduler_band_start(ts, omp_get_thread_num() + 1); tile++)
+					tile_scheduler_push(ts, omp_get_thread_num(), tile);
+			}
 
-		//left/right col
-    #pragma omp parallel for
-		for (i=row_start; i<= row_end; i++) {
-      #pragma omp parallel sections
-      {
-        #pragma omp section
-        {
-      		if (populate(array1, array2, N, M, i, col_start) == 0)
-    				no_change = 0;
-        }
-        #pragma omp section
-        {
-    			if (populate(array1, array2, N, M, i, col_end) == 0)
-    				no_change = 0;
-        }
-      }
-		}
+			#pragma omp master
+			{
+				no_change = 1;
+				ready_strips = 0;
+				taken_strips = duplicate_strips;
+
+				//8 Isend
+				//(partitioned : the up/down edges of this generation were started by the previous one,
+				//and we start the next generation's ones, whose partitions are marked ready as they are computed)
+				if (partitioned)
+				{
+					MPI_Startall(6, &send_request[communication_type][2]);
+					MPI_Startall(2, send_request[1 - communication_type]);
+				}
+				else
+				{
+					MPI_Startall(8, send_request[communication_type]);
+				}
+				//8 IRecv
+				MPI_Startall(8, recv_request[communication_type]);
+			}
+			#pragma omp barrier
 
-		//corners
-    #pragma omp parallel sections
-    {
-      #pragma omp section
-      {
-    		if (populate(array1, array2, N, M, row_start, col_start) == 0)
-    				no_change = 0;
-      }
-      #pragma omp section
-      {
-    		if (populate(array1, array2, N, M, row_start, col_end) == 0)
-    				no_change = 0;
-      }
-      #pragma omp section
-      {
-    		if (populate(array1, array2, N, M, row_end, col_start) == 0)
-    				no_change = 0;
-      }
-      #pragma omp section
-      {
-    		if (populate(array1, array2, N, M, row_end, col_end) == 0)
-    				no_change = 0;
-      }
-    }
+			if (comm_thread)
+			{
+				int my_no_change = 1;
+				int ready, taken, strip;
+
+				//as each receive completes, mark the strips it completes as ready
+				#pragma omp master
+				{
+					int arrived = 0;
+					int dir, ready_now;
+
+					while (1)
+					{
+						MPI_Waitany(8, recv_request[communication_type], &dir, MPI_STATUS_IGNORE);
+						if (dir == MPI_UNDEFINED)
+							break;
+
+						arrived |= 1 << dir;
+						ready_now = 0;
+						for (strip = 0; strip < BORDER_STRIPS; strip++)
+							if ((arrived & strip_needs[strip]) == strip_needs[strip])
+								ready_now |= 1 << strip;
+
+						#pragma omp flush
+						#pragma omp atomic write
+						ready_strips = ready_now;
+					}
+				}
+
+				//inner tiles, ours then stolen ones
+				while ((tile = tile_scheduler_next(ts, omp_get_thread_num())) != -1)
+				{
+					i = row_start + 1 + tile * TILE_ROWS;
+					my_no_change = populate_block(grid1, grid2, i, (i + TILE_ROWS - 1 < row_end - 1) ? i + TILE_ROWS - 1 : row_end - 1,
+						col_start + 1, col_end - 1) && my_no_change;
+				}
 
+				//border strips, each one as soon as its halos are in
+				while (1)
+				{
+					#pragma omp atomic read
+					taken = taken_strips;
+					if (taken == all_strips)
+						break;
+
+					#pragma omp atomic read
+					ready = ready_strips;
+					#pragma omp flush
+
+					for (strip = 0; strip < BORDER_STRIPS; strip++)
+					{
+						if (!(ready & ~taken & (1 << strip)))
+							continue;
+
+						#pragma omp atomic capture
+						{ taken = taken_strips; taken_strips |= 1 << strip; }
+
+						if (!(taken & (1 << strip)))
+							my_no_change = populate_border_strip(grid1, grid2, strip,
+								row_start, row_end, col_start, col_end) && my_no_change;
+					}
+				}
 
-		if ( reduce_rate > 0 && (count + 1) % reduce_rate == 0)
-		{			
-			MPI_Allreduce(&no_change, &no_change_sum, 1, MPI_SHORT, MPI_SUM, virtual_comm);
-			if (no_change_sum == processors )
+				#pragma omp atomic
+				no_change &= my_no_change;
+				#pragma omp barrier
+			}
+			else
 			{
-				if (my_rank == 0 && STATUS) 
-					printf("Terminating because there was no change at loop number %d\n", count);
+				//calculate/populate 'inner' cells
+				//populate functions applies the game's rules
+				//and returns 0 if a change occurs
+				#pragma omp for schedule(static) reduction(&&:no_change)
+				for (i=row_start + 1; i<= row_end - 1; i++) {
+					no_change = (populate_row(grid1, grid2, i, col_start + 1, col_end - 1, NULL) == 0) && no_change;
+				}
 
-				break;
+				//calculate/populate 'outer' cells
+				//a task for each border strip, launched as soon as the receives it needs complete
+				//(the rest of the team picks the tasks up at the barrier)
+				#pragma omp master
+				{
+					int arrived = 0;
+					int launched = duplicate_strips;
+					int dir, strip;
+
+					//the up/down edges (with the corners) go by partition
+					if (partitioned)
+					{
+						launched = (all_strips & ~((1 << 2) | (1 << 3))) | duplicate_strips;
+						memset(partition_launched, 0, 2 * partitions);
+					}
+
+					while (1)
+					{
+						MPI_Waitany(8, recv_request[communication_type], &dir, MPI_STATUS_IGNORE);
+						if (dir == MPI_UNDEFINED)
+							break;
+
+						arrived |= 1 << dir;
+						for (strip = 0; strip < BORDER_STRIPS; strip++)
+						{
+							if ((launched & (1 << strip)) || (arrived & strip_needs[strip]) != strip_needs[strip])
+								continue;
+
+							launched |= 1 << strip;
+							#pragma omp task firstprivate(strip)
+							{
+								int strip_no_change = populate_border_strip(grid1, grid2, strip,
+									row_start, row_end, col_start, col_end);
+								#pragma omp atomic
+								no_change &= strip_no_change;
+							}
+						}
+
+#if MPI_VERSION >= 4
+						//(a block one row thin only computes its up edge)
+						int part;
+						int edge_parts = (rows_per_block < 2) ? partitions : 2 * partitions;
+						for (part = 0; partitioned && part < edge_parts; part++)
+						{
+							if (partition_launched[part] || (arrived & partition_needs[part]) != partition_needs[part])
+								continue;
+
+							partition_launched[part] = 1;
+							#pragma omp task firstprivate(part)
+							{
+								int edge = part / partitions; //HALO up or down
+								int first_col = col_start + (part % partitions) * partition_cols;
+								int part_no_change = populate_block(grid1, grid2, edge ? row_end : row_start, edge ? row_end : row_start,
+									first_col, first_col + partition_cols - 1);
+								MPI_Pready(part % partitions, send_request[1 - communication_type][edge]);
+								//which is its down edge too
+								if (rows_per_block < 2)
+									MPI_Pready(part % partitions, send_request[1 - communication_type][1]);
+								#pragma omp atomic
+								no_change &= part_no_change;
+							}
+						}
+#endif
+					}
+				}
+				#pragma omp barrier
 			}
 
-		}
+			#pragma omp master
+			{
+				count = loop;
 
-		//wait for sends
-		MPI_Waitall(8, send_request[communication_type], statuses);
+				if ( reduce_rate > 0 && (count + 1) % reduce_rate == 0)
+				{
+					MPI_Allreduce(&no_change, &no_change_sum, 1, MPI_INT, MPI_SUM, virtual_comm);
+					if (no_change_sum == processors )
+					{
+						if (my_rank == 0 && STATUS) 
+							printf("Terminating because there was no change at loop number %d\n", count);
 
-		//only the master process prints
-		if (PRINT_STEPS) {
-      short int** array = whole_array->array;
-			gol_array_gather(array, array2, my_rank, processors, row_start, col_start,
-			blocks_per_row, blocks_per_col, rows_per_block, cols_per_block, derived_type_block_array, virtual_comm);
-			if (my_rank == 0) {
-				fflush(stdout);
-				print_array(array, N, M);
-				fflush(stdout);
+						terminate = 1;
+					}
+				}
+
+				if (!terminate)
+				{
+					//wait for sends
+					MPI_Waitall(8, send_request[communication_type], statuses);
+
+					//only the master process prints
+					if (PRINT_STEPS) {
+						gol_cell** array = whole_array->array;
+						gol_array_gather(array, array2, my_rank, processors, row_start, col_start,
+						blocks_per_row, blocks_per_col, rows_per_block, cols_per_block, derived_type_block_array, virtual_comm);
+						if (my_rank == 0) {
+							fflush(stdout);
+							print_array(array, N, M);
+							fflush(stdout);
+						}
+						putchar('\n');
+					}
+
+					//swap arrays (array2 becomes array1)
+					gol_cell** temp;
+					temp = array1;
+					array1 = array2;
+					array2 = temp;
+					gol_grid temp_grid = grid1;
+					grid1 = grid2;
+					grid2 = temp_grid;
+					communication_type = (communication_type + 1) % 2;
+				}
 			}
-			putchar('\n');
+			#pragma omp barrier
+
+			if (terminate)
+				break;
 		}
+	}
+
+#if MPI_VERSION >= 4
+	//the up/down edges of the generation after the last one were sent, receive them so that
+	//no partitioned send is left hanging (an early termination does not swap the arrays)
+	if (partitioned)
+	{
+		int pending_type = terminate ? 1 - communication_type : communication_type;
+		MPI_Startall(2, recv_request[pending_type]);
+		MPI_Waitall(2, recv_request[pending_type], MPI_STATUSES_IGNORE);
+		MPI_Waitall(2, send_request[pending_type], MPI_STATUSES_IGNORE);
 
-		//swap arrays (array2 becomes array1)
-		short int** temp;
-		temp = array1;
-		array1 = array2;
-		array2 = temp;
-		communication_type = (communication_type + 1) % 2;
+		//an early termination skips the wait on the sends of the last generation too
+		if (terminate)
+			MPI_Waitall(2, send_request[communication_type], MPI_STATUSES_IGNORE);
 
+		for (i = 0; i < 2; i++)
+		{
+			for (j = 0; j < 2; j++)
+			{
+				MPI_Request_free(&send_request[i][j]);
+				MPI_Request_free(&recv_request[i][j]);
+			}
+		}
 	}
-
+#endif
+	free(partition_needs);
+	free(partition_launched);
+	tile_scheduler_free(&ts);
 
 	if (my_rank == 0) 
 	{
@@ -771,9 +1052,9 @@ int main(int argc, char* argv[])
 	{
 		//Gather the whole (final) gol array into master so he can print it out
     if (!PRINT_STEPS) {
-      whole_array = gol_array_init(rows_per_block + 2, cols_per_block + 2);
+      whole_array = gol_array_init(N, M);
     }
-    short int** array = whole_array->array;
+    gol_cell** array = whole_array->array;
 		gol_array_gather(array, array1, my_rank, processors, row_start, col_start,
 			blocks_per_row, blocks_per_col, rows_per_block, cols_per_block, derived_type_block_array, virtual_comm);
 		if (my_rank == 0) {
@@ -804,15 +1085,15 @@ int main(int argc, char* argv[])
 void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int processors, int lines, int columns,
 										int rows_per_block, int cols_per_block, int blocks_per_row, MPI_Comm virtual_comm)
 {
-	short int** array = gol_ar->array;
+	gol_cell** array = gol_ar->array;
 	int N = lines;
 	int M = columns;
 	int tag = 201049;
 
 	char line[100];
 	char copy[100];
-	int counter = 0;
-	int successful = 0;
+	long counter = 0;
+	long successful = 0;
 	int row_of_block;
 	int col_of_block;
 	int destination_process;
@@ -850,7 +1131,7 @@ void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int proc
 
 		if (token == NULL)
 		{
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -861,7 +1142,7 @@ void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int proc
 
 		if (token == NULL)
 		{
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -871,7 +1152,7 @@ void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int proc
 		if (row < 1 || row > N || col < 1 || col > M)
 		{
 			printf("Invalid row or column\n");
-			printf("Skipping invalid line (%d): '%s'\n",counter, copy);
+			printf("Skipping invalid line (%ld): '%s'\n",counter, copy);
 			continue;
 		}
 
@@ -910,7 +1191,7 @@ void gol_array_read_file_and_scatter(char* filename, gol_array* gol_ar, int proc
 
 
 	if (INFO)
-		printf("\nSuccesfully read %d coordinates\n", successful);
+		printf("\nSuccesfully read %ld coordinates\n", successful);
 	fclose(file);
 }
 
@@ -937,11 +1218,11 @@ void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines
     }
   }
 
-  short int** array = gol_ar->array;
+  gol_cell** array = gol_ar->array;
 
   srand(time(NULL));
-  int alive_count = rand() % (lines*columns + 1);
-  int i;
+  long alive_count = random_below((long) lines*columns + 1);
+  long i;
   int tag = 201049;
   int row_of_block;
   int col_of_block;
@@ -994,12 +1275,12 @@ void gol_array_generate_and_scatter(gol_array* gol_ar, int processors, int lines
 }
 
 
-void gol_array_gather(short int** array, short int** myarray, int my_rank, int processes, int row_start, int col_start,
+void gol_array_gather(gol_cell** array, gol_cell** myarray, int my_rank, int processes, int row_start, int col_start,
 	int blocks_per_row, int blocks_per_col, int rows_per_block, int cols_per_block, MPI_Datatype block_array, MPI_Comm virtual_comm)
 {
 	int tag = 201400201;
   gol_array* block_gol_array = gol_array_init(rows_per_block + 2, cols_per_block + 2);
-  short int** neighbour_block_array = block_gol_array->array;
+  gol_cell** neighbour_block_array = block_gol_array->array;
 
 	if (my_rank == 0)
 	{
@@ -1007,7 +1288,7 @@ void gol_array_gather(short int** array, short int** myarray, int my_rank, int p
 
     for (int i = 0; i < rows_per_block; i++)
     {
-      memcpy(&(array[i][0]), &(myarray[i+1][1]), cols_per_block*sizeof(short int));
+      memcpy(&(array[i][0]), &(myarray[i+1][1]), cols_per_block*sizeof(gol_cell));
     }
 
 		MPI_Status status;
@@ -1034,7 +1315,7 @@ void gol_array_gather(short int** array, short int** myarray, int my_rank, int p
           for (int i = 1; i <= rows_per_block; i++)
           {
             memcpy(&(array[neighbour_row][neigbour_cstart]),
-                    &(neighbour_block_array[i][1]), cols_per_block*sizeof(short int));
+                    &(neighbour_block_array[i][1]), cols_per_block*sizeof(gol_cell));
             neighbour_row++;
           }
 				}
@@ -1048,3 +1329,34 @@ void gol_array_gather(short int** array, short int** myarray, int my_rank, int p
 
   gol_array_free(&block_gol_array);
 }
+
+//populates the cells of rows row_first..row_last and cols col_first..col_last
+//returns 0 if any of them changed
+int populate_block(gol_grid grid1, gol_grid grid2, int row_first, int row_last, int col_first, int col_last)
+{
+	int i;
+	int no_change = 1;
+
+	for (i = row_first; i <= row_last; i++)
+		no_change = (populate_row(grid1, grid2, i, col_first, col_last, NULL) == 0) && no_change;
+
+	return no_change;
+}
+
+//populates one of the BORDER_STRIPS strips of the block's border
+//returns 0 if any of its cells changed
+int populate_border_strip(gol_grid grid1, gol_grid grid2, int strip,
+	int row_start, int row_end, int col_start, int col_end)
+{
+	switch (strip)
+	{
+		case 0: return populate_block(grid1, grid2, row_start, row_start, col_start + 1, col_end - 1);
+		case 1: return populate_block(grid1, grid2, row_end, row_end, col_start + 1, col_end - 1);
+		case 2: return populate_col(grid1, grid2, col_start, row_start + 1, row_end - 1, NULL) == 0;
+		case 3: return populate_col(grid1, grid2, col_end, row_start + 1, row_end - 1, NULL) == 0;
+		case 4: return populate_block(grid1, grid2, row_start, row_start, col_start, col_start);
+		case 5: return populate_block(grid1, grid2, row_start, row_start, col_end, col_end);
+		case 6: return populate_block(grid1, grid2, row_end, row_end, col_start, col_start);
+		default: return populate_block(grid1, grid2, row_end, row_end, col_end, col_end);
+	}
+}
@@ -0,0 +1,663 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sched.h>
+
+#include <omp.h>
+
+#include "./gol_lib/gol_array.h"
+#include "./gol_lib/functions.h"
+#include "./gol_lib/tile_scheduler.h"
+#include "./gol_lib/gol_snapshot.h"
+
+#define INFO 1
+#define STATUS 1
+#define TIME 1
+#define PRINT_INITIAL 0
+#define PRINT_FINAL 0
+#define DEFAULT_N 420
+#define DEFAULT_M 420
+#define MAX_LOOPS 200
+#define NUM_THREADS 2
+#define PIN_THREADS 1 //pin thread i to the i-th cpu we are allowed to run on (-a)
+#define CACHE_LINE 64
+#define TILE_ROWS 16 //tiles of the 'steal' engine
+#define TILE_COLS 64
+#define TIME_BLOCK 8 //generations played in one go by the 'wavefront' engine (at most)
+
+//engines (-e)
+#define ENGINE_STATIC 0 //a band of rows per thread, a barrier per generation
+#define ENGINE_STEAL 1 //tiles that (may have) changed, spread over per thread deques, idle threads steal
+#define ENGINE_BANDS 2 //a band of rows per thread, each thread only waits for the two bands next to it
+#define ENGINE_WAVEFRONT 3 //trapezoids of (row, generation) per thread, two barriers every TIME_BLOCK generations
+#define ENGINE ENGINE_STATIC
+
+//a per thread flag, alone in its cache line so that threads do not write to each other's lines
+struct padded_flag
+{
+	int value;
+	char pad[CACHE_LINE - sizeof(int)];
+};
+
+typedef struct padded_flag padded_flag;
+
+static const char* engine_names[] = { "static", "steal", "bands", "wavefront" };
+
+int band_start(int thread, int threads, int lines);
+int pin_thread(int thread, cpu_set_t* allowed);
+int play_static(gol_grid array1, gol_grid array2, int N, int M, int max_loops, int threads,
+	padded_flag* no_change, gol_grid* final_array);
+int play_steal(gol_grid array1, gol_grid array2, int N, int M, int max_loops, int threads,
+	padded_flag* no_change, gol_grid* final_array);
+int tile_active(char* changed, int tile, int tile_lines, int tile_columns);
+int play_bands(gol_grid array1, gol_grid array2, int N, int M, int max_loops, int threads,
+	padded_flag* done, gol_grid* final_array);
+int play_wavefront(gol_grid array1, gol_grid array2, int N, int M, int max_loops, int threads,
+	gol_grid* final_array);
+
+int main(int argc, char* argv[])
+{
+	int N = -1;
+	int M = -1;
+	int max_loops = MAX_LOOPS;
+	int threads = NUM_THREADS;
+	int pin = PIN_THREADS;
+	int engine = ENGINE;
+	char* filename = NULL;
+	char* snapshot = NULL;
+	char* output = NULL;
+	long generation = 0; //of the game we start from
+	int i, j;
+
+	i = 0;
+	while (++i < argc)
+	{
+		if ( !strcmp(argv[i], "-f") )
+		{
+			filename = argv[i+1];
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-l") )
+		{
+			N = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-c") )
+		{
+			M = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-m") )
+		{
+			max_loops = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-t") )
+		{
+			threads = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-a") )
+		{
+			pin = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-s") )
+		{
+			snapshot = argv[i+1];
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-o") )
+		{
+			output = argv[i+1];
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-e") )
+		{
+			for (engine = (int) (sizeof(engine_names) / sizeof(engine_names[0])) - 1; engine >= 0; engine--)
+				if ( !strcmp(argv[i+1], engine_names[engine]) )
+					break;
+			i++;
+		}
+	}
+
+	//a snapshot brings its size (and the generations already played)
+	if (snapshot != NULL)
+	{
+		gol_snapshot* snap = gol_snapshot_open(snapshot, 0);
+		if (snap == NULL)
+			return -1;
+
+		N = snap->lines;
+		M = snap->columns;
+		generation = snap->header->generation;
+		gol_snapshot_close(&snap);
+	}
+
+	if (N == -1 || M == -1)
+	{
+		N = DEFAULT_N;
+		M = DEFAULT_M;
+
+		if (INFO)
+		{
+			printf("Running with default matrix size %dx%d\n", N, M);
+			printf("Usage : './gol_openmp -f <filename> -l <N> -c <M> -m <max_loops> -t <threads> -a <pin threads> -e <static|steal|bands|wavefront> -s <snapshot> -o <output snapshot>\n");
+		}
+	}
+	else if (N <= 0 || M <= 0)
+	{
+		printf("Invalid arguments given!");
+		printf("Usage : './gol_openmp -f <filename> -l <N> -c <M> -m <max_loops> -t <threads> -a <pin threads> -e <static|steal|bands|wavefront> -s <snapshot> -o <output snapshot>\n");
+		printf("Aborting...\n");
+		return -1;
+	}
+
+	if (engine < 0)
+	{
+		printf("Unknown engine, use one of static, steal, bands, wavefront\n");
+		return -1;
+	}
+
+	//no more threads than rows, every thread owns a band of at least one row
+	if (threads < 1)
+		threads = 1;
+	if (threads > N)
+		threads = N;
+
+	omp_set_num_threads(threads);
+
+	//allocate two NxM gol_arrays (one aligned arena with padded rows), without touching them
+	//Each thread zeroes the rows of its band so that their pages land on its NUMA node.
+	//The same (pinned) threads compute these bands in every generation
+	gol_array* ga1;
+	gol_array* ga2;
+	gol_array_init_arena(N, M, 0, &ga1, &ga2);
+	int* cpus = malloc(threads * sizeof(int));
+	cpu_set_t allowed;
+
+	sched_getaffinity(0, sizeof(cpu_set_t), &allowed);
+
+	#pragma omp parallel num_threads(threads) private(i)
+	{
+		int thread = omp_get_thread_num();
+		int first = band_start(thread, threads, N);
+		int last = band_start(thread + 1, threads, N) - 1;
+
+		cpus[thread] = pin ? pin_thread(thread, &allowed) : sched_getcpu();
+
+		for (i = first; i <= last; i++)
+		{
+			memset(ga1->array[i], 0, M * sizeof(gol_cell));
+			memset(ga2->array[i], 0, M * sizeof(gol_cell));
+		}
+	}
+
+	if (INFO)
+	{
+		printf("N = %d\nM = %d\nthreads = %d\nengine = %s\n", N, M, threads, engine_names[engine]);
+		printf("Thread affinity map (%s):", pin ? "pinned" : "not pinned");
+		for (j = 0; j < threads; j++)
+			printf(" %d->cpu%d", j, cpus[j]);
+		putchar('\n');
+	}
+
+	if (snapshot != NULL)
+	{
+		gol_snapshot_read_array(snapshot, ga1);
+	}
+	else if (filename != NULL)
+	{
+		gol_array_read_file(filename, ga1);
+	}
+	else//no input file given, generate a random game array
+	{
+		if (INFO)
+			printf("No input file given, generating a random game of life array to play\n");
+		gol_array_generate(ga1);
+	}
+
+	if (PRINT_INITIAL)
+	{
+		printf("Printing initial array:\n\n");
+		print_array(ga1->array, N, M);
+		putchar('\n');
+	}
+
+	//the change flags of two generations, so that a flag is not rewritten while others still read it
+	padded_flag* no_change;
+	int ret = posix_memalign((void**) &no_change, CACHE_LINE, 2 * threads * sizeof(padded_flag));
+	assert(ret == 0);
+
+	gol_grid final_array;
+	int loops;
+
+	if (STATUS)
+		printf("Starting the Game of Life\n");
+
+	double start = omp_get_wtime();
+
+	if (engine == ENGINE_STEAL)
+		loops = play_steal(gol_array_grid(ga1), gol_array_grid(ga2), N, M, max_loops, threads, no_change, &final_array);
+	else if (engine == ENGINE_BANDS)
+		loops = play_bands(gol_array_grid(ga1), gol_array_grid(ga2), N, M, max_loops, threads, no_change, &final_array);
+	else if (engine == ENGINE_WAVEFRONT)
+		loops = play_wavefront(gol_array_grid(ga1), gol_array_grid(ga2), N, M, max_loops, threads, &final_array);
+	else
+		loops = play_static(gol_array_grid(ga1), gol_array_grid(ga2), N, M, max_loops, threads, no_change, &final_array);
+
+	double elapsed = omp_get_wtime() - start;
+
+	if (STATUS)
+	{
+		if (loops < max_loops)
+			printf("Terminating because there was no change at loop number %d\n", loops + 1);
+		else
+			printf("Max loop number (%d) was reached. Terminating Game of Life\n", max_loops);
+	}
+
+	if (TIME)
+		printf("Time elapsed: %f seconds\n", elapsed);
+
+	if (PRINT_FINAL)
+		print_array((final_array.cells == ga1->flat_array) ? ga1->array : ga2->array, N, M);
+
+	if (output != NULL)
+		gol_snapshot_write_array(output, (final_array.cells == ga1->flat_array) ? ga1 : ga2, generation + loops);
+
+	free(no_change);
+	free(cpus);
+	gol_array_free(&ga1);
+	gol_array_free(&ga2);
+
+	return 0;
+}
+
+//first row of a thread's band (band_start(threads, ...) is the number of lines)
+int band_start(int thread, int threads, int lines)
+{
+	return (int) ((long) thread * lines / threads);
+}
+
+//pins the calling thread to the thread-th of the allowed cpus (round robin)
+//returns the cpu it runs on
+int pin_thread(int thread, cpu_set_t* allowed)
+{
+	int cpu_count = CPU_COUNT(allowed);
+	int nth = thread % cpu_count;
+	int cpu;
+	cpu_set_t mine;
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+	{
+		if (CPU_ISSET(cpu, allowed) && nth-- == 0)
+			break;
+	}
+
+	CPU_ZERO(&mine);
+	CPU_SET(cpu, &mine);
+	if (sched_setaffinity(0, sizeof(cpu_set_t), &mine) != 0)
+		perror("sched_setaffinity");
+
+	return sched_getcpu();
+}
+
+//every thread computes its band of rows, then a barrier ends the generation
+//returns the generations played (less than max_loops if the game stopped changing)
+int play_static(gol_grid array1, gol_grid array2, int N, int M, int max_loops, int threads,
+	padded_flag* no_change, gol_grid* final_array)
+{
+	int loops = max_loops;
+
+	#pragma omp parallel num_threads(threads)
+	{
+		int thread = omp_get_thread_num();
+		int first = band_start(thread, threads, N);
+		int last = band_start(thread + 1, threads, N) - 1;
+		gol_grid current = array1;
+		gol_grid next = array2;
+		gol_grid temp;
+		int loop, i, k;
+
+		for (loop = 0; loop < max_loops; loop++)
+		{
+			padded_flag* flags = &no_change[(loop % 2) * threads];
+			int my_no_change = 1;
+			int all_no_change = 1;
+
+			for (i = first; i <= last; i++)
+				my_no_change = (populate_row(current, next, i, 0, M - 1, NULL) == 0) && my_no_change;
+
+			flags[thread].value = my_no_change;
+
+			#pragma omp barrier
+
+			for (k = 0; k < threads; k++)
+				all_no_change = all_no_change && flags[k].value;
+
+			//every thread sees the same flags, so they all stop at the same generation
+			if (all_no_change)
+				break;
+
+			temp = current;
+			current = next;
+			next = temp;
+		}
+
+		if (thread == 0)
+		{
+			loops = loop;
+			*final_array = current;
+		}
+	}
+
+	return loops;
+}
+
+//a tile has to be computed if it or one of its 8 neighbour tiles changed in the previous generation
+//(otherwise it is the same as in the previous generation, and the array we write to already has it)
+int tile_active(char* changed, int tile, int tile_lines, int tile_columns)
+{
+	int row = tile / tile_columns;
+	int col = tile % tile_columns;
+	int i, j;
+
+	for (i = -1; i <= 1; i++)
+		for (j = -1; j <= 1; j++)
+			if (changed[((row + i + tile_lines) % tile_lines) * tile_columns + (col + j + tile_columns) % tile_columns])
+				return 1;
+
+	return 0;
+}
+
+//every thread pushes the active tiles of its band of tiles to its deque, then takes tiles
+//from its deque or steals them from the others until there are none left, and a barrier ends the generation
+//returns the generations played (less than max_loops if the game stopped changing)
+int play_steal(gol_grid array1, gol_grid array2, int N, int M, int max_loops, int threads,
+	padded_flag* no_change, gol_grid* final_array)
+{
+	int tile_lines = (N + TILE_ROWS - 1) / TILE_ROWS;
+	int tile_columns = (M + TILE_COLS - 1) / TILE_COLS;
+	int tiles = tile_lines * tile_columns;
+	int loops = max_loops;
+
+	//whether each tile changed, in this and in the previous generation
+	char* changed = malloc(2 * tiles);
+	tile_scheduler* ts = tile_scheduler_init(threads, tiles);
+
+	#pragma omp parallel num_threads(threads)
+	{
+		int thread = omp_get_thread_num();
+		int first = tile_scheduler_band_start(ts, thread);
+		int last = tile_scheduler_band_start(ts, thread + 1) - 1;
+		gol_grid current = array1;
+		gol_grid next = array2;
+		gol_grid temp;
+		int loop, tile, i, k;
+
+		for (loop = 0; loop < max_loops; loop++)
+		{
+			padded_flag* flags = &no_change[(loop % 2) * threads];
+			char* changed_now = &changed[(loop % 2) * tiles];
+			char* changed_before = &changed[((loop + 1) % 2) * tiles];
+			int my_no_change = 1;
+			int all_no_change = 1;
+
+			tile_scheduler_reset(ts, thread);
+			for (tile = first; tile <= last; tile++)
+			{
+				if (loop == 0 || tile_active(changed_before, tile, tile_lines, tile_columns))
+					tile_scheduler_push(ts, thread, tile);
+				else
+					changed_now[tile] = 0;
+			}
+
+			#pragma omp barrier
+
+			while ((tile = tile_scheduler_next(ts, thread)) != -1)
+			{
+				int row_start = (tile / tile_columns) * TILE_ROWS;
+				int col_start = (tile % tile_columns) * TILE_COLS;
+				int row_end = (row_start + TILE_ROWS < N) ? row_start + TILE_ROWS : N;
+				int col_end = (col_start + TILE_COLS < M) ? col_start + TILE_COLS : M;
+				int tile_no_change = 1;
+
+				for (i = row_start; i < row_end; i++)
+					tile_no_change = (populate_row(current, next, i, col_start, col_end - 1, NULL) == 0) && tile_no_change;
+
+				changed_now[tile] = !tile_no_change;
+				my_no_change = my_no_change && tile_no_change;
+			}
+
+			flags[thread].value = my_no_change;
+
+			#pragma omp barrier
+
+			for (k = 0; k < threads; k++)
+				all_no_change = all_no_change && flags[k].value;
+
+			if (all_no_change)
+				break;
+
+			temp = current;
+			current = next;
+			next = temp;
+		}
+
+		if (thread == 0)
+		{
+			loops = loop;
+			*final_array = current;
+		}
+	}
+
+	tile_scheduler_free(&ts);
+	free(changed);
+
+	return loops;
+}
+
+//every thread computes its band of rows, without barriers
+//Generation g of a band reads the rows next to it from the bands above and below, and overwrites
+//what they read in generation g - 1, so it only waits for these two bands to have done g generations.
+//A thread can then be one generation ahead of its neighbours, and threads/2 ahead of the farthest band.
+//The last thread to finish a generation sees if no band changed in it, and then everyone stops
+//(the generations some threads played after that are the same, so both arrays have the final state)
+//returns the generations played (less than max_loops if the game stopped changing)
+int play_bands(gol_grid array1, gol_grid array2, int N, int M, int max_loops, int threads,
+	padded_flag* done, gol_grid* final_array)
+{
+	//per generation (modulo the most generations that threads can be apart), the threads that
+	//finished it and how many of them did not change their band
+	int ring = threads + 2;
+	int* finished = calloc(ring, sizeof(int));
+	int* unchanged = calloc(ring, sizeof(int));
+	int stop_at = max_loops;
+	int k;
+
+	for (k = 0; k < threads; k++)
+		done[k].value = 0;
+
+	#pragma omp parallel num_threads(threads)
+	{
+		int thread = omp_get_thread_num();
+		int up = (thread - 1 + threads) % threads;
+		int down = (thread + 1) % threads;
+		int first = band_start(thread, threads, N);
+		int last = band_start(thread + 1, threads, N) - 1;
+		gol_grid current = array1;
+		gol_grid next = array2;
+		gol_grid temp;
+		int loop, i, stop, up_done, down_done, finished_before;
+
+		for (loop = 0; loop < max_loops; loop++)
+		{
+			int my_no_change = 1;
+
+			//wait for our neighbours (or for the game to end)
+			do {
+				#pragma omp atomic read seq_cst
+				stop = stop_at;
+				#pragma omp atomic read seq_cst
+				up_done = done[up].value;
+				#pragma omp atomic read seq_cst
+				down_done = done[down].value;
+			} while (loop <= stop && (up_done < loop || down_done < loop));
+
+			if (loop > stop)
+				break;
+
+			#pragma omp flush
+
+			for (i = first; i <= last; i++)
+				my_no_change = (populate_row(current, next, i, 0, M - 1, NULL) == 0) && my_no_change;
+
+			#pragma omp flush
+			#pragma omp atomic write seq_cst
+			done[thread].value = loop + 1;
+
+			if (my_no_change)
+			{
+				#pragma omp atomic update seq_cst
+				unchanged[loop % ring]++;
+			}
+
+			#pragma omp atomic capture seq_cst
+			finished_before = finished[loop % ring]++;
+
+			//we are the last to finish this generation, the others are in the next ones
+			if (finished_before == threads - 1)
+			{
+				int unchanged_bands;
+
+				#pragma omp atomic read seq_cst
+				unchanged_bands = unchanged[loop % ring];
+
+				if (unchanged_bands == threads)
+				{
+					#pragma omp critical (bands_stop)
+					if (loop < stop_at)
+					{
+						#pragma omp atomic write seq_cst
+						stop_at = loop;
+					}
+				}
+
+				#pragma omp atomic write seq_cst
+				unchanged[loop % ring] = 0;
+				#pragma omp atomic write seq_cst
+				finished[loop % ring] = 0;
+			}
+
+			temp = current;
+			current = next;
+			next = temp;
+		}
+	}
+
+	//after max_loops generations the last one is in array1 if max_loops is even
+	*final_array = (max_loops % 2 == 0) ? array1 : array2;
+
+	free(finished);
+	free(unchanged);
+
+	return stop_at;
+}
+
+//plays up to TIME_BLOCK generations ('levels' 1..depth of a block, level 0 being where the block starts)
+//with two barriers, and both arrays. Level k is written to the array level k - 2 was in.
+//Phase 1: every thread computes a shrinking trapezoid of its band, rows [start + k - 1, end - k + 1) of level k,
+//which only needs its own band of the previous level.
+//Phase 2: every thread fills the growing triangle around the row its band starts at,
+//rows [start - k + 1, start + k - 1) of level k, from the trapezoids on both sides.
+//The rows a level reads are never overwritten by later levels of phase 1, so two arrays are enough,
+//as long as no band is thinner than 2 * (depth - 1) rows.
+//returns the generations played (less than max_loops if the game stopped changing)
+int play_wavefront(gol_grid array1, gol_grid array2, int N, int M, int max_loops, int threads,
+	gol_grid* final_array)
+{
+	int depth = N / threads / 2 + 1;
+	int loops = max_loops;
+	int played = 0;
+	char level_changed[TIME_BLOCK + 1];
+
+	if (depth > TIME_BLOCK)
+		depth = TIME_BLOCK;
+
+	if (INFO)
+		printf("Playing up to %d generations per block\n", depth);
+
+	gol_grid levels[2] = { array1, array2 }; //level k is in levels[k % 2]
+
+	while (played < max_loops && loops == max_loops)
+	{
+		int block = (max_loops - played < depth) ? max_loops - played : depth;
+		int k;
+
+		memset(level_changed, 0, sizeof(level_changed));
+
+		#pragma omp parallel num_threads(threads) private(k)
+		{
+			int thread = omp_get_thread_num();
+			int start = band_start(thread, threads, N);
+			int end = band_start(thread + 1, threads, N);
+			int row;
+
+			for (k = 1; k <= block; k++)
+			{
+				int level_no_change = 1;
+
+				for (row = start + k - 1; row < end - k + 1; row++)
+					level_no_change = (populate_row(levels[(k - 1) % 2], levels[k % 2], row, 0, M - 1, NULL) == 0) && level_no_change;
+
+				if (!level_no_change)
+				{
+					#pragma omp atomic write
+					level_changed[k] = 1;
+				}
+			}
+
+			#pragma omp barrier
+
+			for (k = 2; k <= block; k++)
+			{
+				int level_no_change = 1;
+
+				for (row = start - k + 1; row < start + k - 1; row++)
+					level_no_change = (populate_row(levels[(k - 1) % 2], levels[k % 2], (row + N) % N, 0, M - 1, NULL) == 0) && level_no_change;
+
+				if (!level_no_change)
+				{
+					#pragma omp atomic write
+					level_changed[k] = 1;
+				}
+			}
+		}
+
+		//the first generation of the block with no change stops the game, like the other engines
+		//(the ones after it are the same, so the last level has the final state)
+		for (k = 1; k <= block; k++)
+		{
+			if (!level_changed[k])
+			{
+				loops = played + k - 1;
+				break;
+			}
+		}
+
+		played += block;
+
+		if (block % 2 == 1)
+		{
+			gol_grid temp = levels[0];
+			levels[0] = levels[1];
+			levels[1] = temp;
+		}
+	}
+
+	*final_array = levels[0];
+
+	return loops;
+}
@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "./gol_lib/gol_array.h"
+#include "./gol_lib/functions.h"
+#include "./gol_lib/gol_snapshot.h"
+
+#define INFO 1
+#define STATUS 1
+#define TIME 1
+#define PRINT_INITIAL 0
+#define PRINT_FINAL 0
+#define DEFAULT_N 420
+#define DEFAULT_M 420
+#define MAX_LOOPS 200
+#define PASS_GENERATIONS 8 //generations played in one pass over the snapshot (at most)
+#define BAND_ROWS 1024 //rows read (and written) between two releases of their pages
+#define OUTPUT_SNAPSHOT "gol_stream.snap"
+#define CACHE_LINE 64
+
+int play_pass(gol_snapshot* current, gol_snapshot* next, int generations);
+
+int main(int argc, char* argv[])
+{
+	int N = -1;
+	int M = -1;
+	int max_loops = MAX_LOOPS;
+	int pass_generations = PASS_GENERATIONS;
+	char* filename = NULL;
+	char* input = NULL;
+	char* output = OUTPUT_SNAPSHOT;
+	int i;
+
+	i = 0;
+	while (++i < argc)
+	{
+		if ( !strcmp(argv[i], "-f") )
+		{
+			filename = argv[i+1];
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-s") )
+		{
+			input = argv[i+1];
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-o") )
+		{
+			output = argv[i+1];
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-l") )
+		{
+			N = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-c") )
+		{
+			M = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-m") )
+		{
+			max_loops = atoi(argv[i+1]);
+			i++;
+		}
+		else if ( !strcmp(argv[i], "-k") )
+		{
+			pass_generations = atoi(argv[i+1]);
+			i++;
+		}
+	}
+
+	if (input == NULL && (N == -1 || M == -1))
+	{
+		N = DEFAULT_N;
+		M = DEFAULT_M;
+
+		if (INFO)
+		{
+			printf("Running with default matrix size %dx%d\n", N, M);
+			printf("Usage : './gol_stream -f <filename> -l <N> -c <M> | -s <snapshot>, -o <output snapshot> -m <max_loops> -k <generations per pass>\n");
+		}
+	}
+	else if (input == NULL && (N <= 0 || M <= 0))
+	{
+		printf("Invalid arguments given!");
+		printf("Usage : './gol_stream -f <filename> -l <N> -c <M> | -s <snapshot>, -o <output snapshot> -m <max_loops> -k <generations per pass>\n");
+		printf("Aborting...\n");
+		return -1;
+	}
+
+	if (pass_generations < 1)
+		pass_generations = 1;
+
+	//the game is only ever in the snapshots: generation 0 is the input snapshot (never written to),
+	//or the output one filled from the coordinates file. Passes then go back and forth between
+	//the output snapshot and a temporary one next to it
+	char* names[2];
+	names[0] = output;
+	names[1] = malloc(strlen(output) + 5);
+	assert(names[1] != NULL);
+	sprintf(names[1], "%s.tmp", output);
+
+	gol_snapshot* current;
+	int current_name; //index in names, -1 for the input snapshot
+
+	if (input != NULL)
+	{
+		current = gol_snapshot_open(input, 0);
+		current_name = -1;
+		if (current == NULL)
+			return -1;
+
+		N = current->lines;
+		M = current->columns;
+	}
+	else
+	{
+		current = gol_snapshot_create(output, N, M);
+		current_name = 0;
+		if (current == NULL)
+			return -1;
+
+		if (filename != NULL)
+		{
+			long read = gol_snapshot_read_file(filename, current);
+			if (read < 0)
+				return -1;
+			if (INFO)
+				printf("\nSuccesfully read %ld coordinates\n", read);
+		}
+		else//no input file given, generate a random game
+		{
+			if (INFO)
+				printf("No input file given, generating a random game of life snapshot to play\n");
+			gol_snapshot_generate(current);
+		}
+	}
+
+	if (INFO)
+		printf("N = %d\nM = %d\ngenerations per pass = %d\nsnapshot = %s\n", N, M, pass_generations, output);
+
+	if (PRINT_INITIAL)
+	{
+		printf("Printing initial array:\n\n");
+		gol_snapshot_print(current);
+		putchar('\n');
+	}
+
+	long generation = current->header->generation;
+	int loops = 0;
+	int terminated = 0;
+	struct timespec start, finish;
+
+	if (STATUS)
+		printf("Starting the Game of Life\n");
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (loops < max_loops && !terminated)
+	{
+		int generations = (max_loops - loops < pass_generations) ? max_loops - loops : pass_generations;
+		int next_name = (current_name == 0) ? 1 : 0;
+		gol_snapshot* next = gol_snapshot_create(names[next_name], N, M);
+
+		if (next == NULL)
+			return -1;
+
+		//the generations of the pass that changed the game
+		int changed = play_pass(current, next, generations);
+
+		//once a generation did not change the game, the rest of the pass did not either
+		if (changed < generations)
+		{
+			generations = changed;
+			terminated = 1;
+		}
+
+		loops += generations;
+		generation += generations;
+		next->header->generation = generation;
+		gol_snapshot_close(&current);
+		current = next;
+		current_name = next_name;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+
+	if (STATUS)
+	{
+		if (terminated)
+			printf("Terminating because there was no change at loop number %d\n", loops + 1);
+		else
+			printf("Max loop number (%d) was reached. Terminating Game of Life\n", max_loops);
+	}
+
+	if (TIME)
+		printf("Time elapsed: %f seconds\n", (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9);
+
+	if (PRINT_FINAL)
+		gol_snapshot_print(current);
+
+	gol_snapshot_close(&current);
+
+	//the last generation goes to the output snapshot
+	if (current_name == 1)
+		rename(names[1], names[0]);
+	else
+		unlink(names[1]);
+
+	free(names[1]);
+
+	return 0;
+}
+
+//plays generations of the game from current into next, going through the snapshots once
+//Generation g of row i needs rows i-1, i, i+1 of generation g-1, so the rows of generation g
+//are computed one behind those of generation g-1, each generation keeping the last 3 of its rows
+//(rows are unpacked into these windows, and only the last generation is packed again).
+//As the rows wrap around, generation g is computed for rows -(generations-g) .. N-1+(generations-g),
+//so that the last one has all the rows 0..N-1 it needs.
+//returns the generations that changed the game (less than generations if one of them did not)
+int play_pass(gol_snapshot* current, gol_snapshot* next, int generations)
+{
+	int N = current->lines;
+	int M = current->columns;
+	int stride = (M + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+	gol_cell* windows;
+	int ret = posix_memalign((void**) &windows, CACHE_LINE, (size_t) (generations + 1) * 3 * stride * sizeof(gol_cell));
+	assert(ret == 0);
+	gol_grid* window = malloc((generations + 1) * sizeof(gol_grid));
+	int* changed = calloc(generations + 1, sizeof(int));
+	int released_current = 0;
+	int released_next = 0;
+	int t, g;
+
+	assert(window != NULL && changed != NULL);
+
+	//3 rows of every generation, row i goes to (i + generations) % 3
+	for (g = 0; g <= generations; g++)
+	{
+		window[g].cells = windows + (size_t) g * 3 * stride;
+		window[g].lines = 3;
+		window[g].columns = M;
+		window[g].stride = stride;
+	}
+
+	for (t = 0; t < N + 2 * generations; t++)
+	{
+		int row = t - generations;
+
+		gol_snapshot_unpack_row(current, (row % N + N) % N, gol_grid_row(window[0], t % 3));
+
+		//generation g computes row row - g, once it has the row after it
+		for (g = 1; g <= generations && 2 * g <= t; g++)
+		{
+			int i = row - g;
+
+			if (populate_row(window[g-1], window[g], (t - g) % 3, 0, M - 1, NULL) != 0 && i >= 0 && i < N)
+				changed[g] = 1;
+
+			if (g == generations && i >= 0)
+				gol_snapshot_pack_row(next, i, gol_grid_row(window[g], (t - g) % 3));
+		}
+
+		//let the rows we are done with go, a band at a time
+		if (row - released_current >= BAND_ROWS)
+		{
+			gol_snapshot_release_rows(current, released_current, row - 2);
+			released_current = row - 1;
+		}
+		if (row - generations - released_next >= BAND_ROWS)
+		{
+			gol_snapshot_release_rows(next, released_next, row - generations);
+			released_next = row - generations + 1;
+		}
+	}
+
+	gol_snapshot_release_rows(current, released_current, N - 1);
+	gol_snapshot_release_rows(next, released_next, N - 1);
+
+	for (g = 1; g <= generations && changed[g]; g++)
+		;
+
+	free(windows);
+	free(window);
+	free(changed);
+
+	return g - 1;
+}